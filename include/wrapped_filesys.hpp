@@ -42,14 +42,34 @@
 #ifndef WRAPPED_FILESYS_HPP
 #define WRAPPED_FILESYS_HPP
 
-#include <cstddef>      // size_t
+#include <cstddef>      // size_t, ptrdiff_t
+#include <cstdint>      // int64_t, uint64_t
+#include <cstring>      // strlen
+#include <iterator>     // forward_iterator_tag
 #include <algorithm>    // min
 #include <string>       // string
 #include <vector>       // vector
 #include <iostream>     // istream, ostream
-#include <sstream>      // stringstream
+#include <sstream>      // ostringstream
 #include <fstream>      // ifstream, ofstream
 #include <stdexcept>    // runtime_error
+#include <cstdio>       // snprintf
+#include <type_traits>  // enable_if, is_integral, is_floating_point
+#include <system_error> // error_code
+#include <chrono>       // duration_cast, nanoseconds, steady_clock
+#include <memory>       // unique_ptr
+#include <mutex>        // mutex, lock_guard
+#include <thread>       // thread
+#include <unordered_map>// unordered_map
+#include <unordered_set>// unordered_set
+#include <map>          // map
+#include <deque>        // deque
+#include <functional>   // function
+#include <condition_variable> // condition_variable
+#include <atomic>       // atomic
+#include <exception>    // exception_ptr, rethrow_exception
+#include <tuple>        // tuple, make_tuple
+#include <new>          // bad_alloc
 
 // Compiler version.
 #ifdef _MSVC_LANG
@@ -62,11 +82,55 @@
     #error "The wrapped_filesys library just useable in c++11 and above."
 #endif // _WRAPPED_FILESYS_CPPVERS < 201103L
 
+// Check C++14 support.
+#if _WRAPPED_FILESYS_CPPVERS >= 201402L
+    #define _WRAPPED_FILESYS_CPP14
+#endif // _WRAPPED_FILESYS_CPPVERS >= 201402L
+
 // Check C++17 support.
 #if _WRAPPED_FILESYS_CPPVERS >= 201703L
     #define _WRAPPED_FILESYS_CPP17
 #endif // WRAPPED_FILESYS_CPPVERS >= 201703L
 
+// The relaxed constexpr (loops and multiple statements) is available since C++14.
+#ifdef _WRAPPED_FILESYS_CPP14
+    #define _WRAPPED_FILESYS_CONSTEXPR14 constexpr
+#else
+    #define _WRAPPED_FILESYS_CONSTEXPR14 inline
+#endif // _WRAPPED_FILESYS_CPP14
+
+// The immediate function is available since C++20.
+#if defined(__cpp_consteval) && __cpp_consteval >= 201811L
+    #define _WRAPPED_FILESYS_CONSTEVAL_ENABLED
+    #define _WRAPPED_FILESYS_CONSTEVAL consteval
+#else
+    #define _WRAPPED_FILESYS_CONSTEVAL _WRAPPED_FILESYS_CONSTEXPR14
+#endif // __cpp_consteval >= 201811L
+
+// The coroutine is available since C++20.
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && defined(__has_include)
+    #if __has_include(<coroutine>)
+        #define _WRAPPED_FILESYS_COROUTINE
+        #include <coroutine>    // coroutine_handle
+        #include <optional>     // optional
+    #endif // __has_include(<coroutine>)
+#endif // __cpp_impl_coroutine >= 201902L
+
+#ifdef _WRAPPED_FILESYS_CPP17
+    #include <string_view>  // string_view
+#endif // _WRAPPED_FILESYS_CPP17
+
+// Check POSIX platform.
+#if defined(__unix__) || defined(__APPLE__)
+    #define _WRAPPED_FILESYS_POSIX
+#endif // __unix__ || __APPLE__
+
+// Check SSE2 support (it's always available in x86-64).
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define _WRAPPED_FILESYS_SSE2
+    #include <emmintrin.h>  // _mm_*
+#endif // __SSE2__ || _M_X64 || _M_IX86_FP >= 2
+
 #ifdef WFS_IMPL
     #define WFS_API 
 #else
@@ -101,8 +165,6 @@ using IFStream  = std::ifstream;
 using OFStream  = std::ofstream;
 using Exception = std::runtime_error;
 
-constexpr int _BUFFER_SIZE = 4096;
-
 // Preferred path separator.
 constexpr char WIN_PATH_SEPARATOR       = '\\';
 constexpr char POSIX_PATH_SEPARATOR     = '/';
@@ -119,1263 +181,9199 @@ constexpr char POSIX_PATH_SEPARATOR     = '/';
     constexpr const char* FILENAME_INVALID_CHARS = "/";
 #endif // _WIN32
 
-} // namespace wfs
+/// @brief The type of the filesystem entity.
+enum class FileType
+{
+    NotFound,
+    Regular,
+    Directory,
+    Symlink,
+    Block,
+    Character,
+    Fifo,
+    Socket,
+    Unknown
+};
 
-// Utility functions with not filesystem.
-namespace wfs
+/// @brief The metadata of the filesystem entity.
+/// @note The times are the nanoseconds since the Unix epoch in POSIX platforms,
+/// and since the epoch of the std::filesystem::file_time_type in other platforms (the ctime is not available).
+struct FileStatus
 {
+    FileType type   = FileType::NotFound;
+    /// @brief The size in bytes.
+    size_t size     = 0;
+    /// @brief The count of the allocated 512-byte blocks.
+    size_t blocks   = 0;
+    /// @brief The preferred block size for the I/O.
+    size_t blockSize = 0;
+    int64_t mtime   = 0;
+    int64_t ctime   = 0;
+    /// @brief The permission bits.
+    unsigned mode   = 0;
+    uint64_t inode  = 0;
+    uint64_t device = 0;
+    size_t nlink    = 0;
+
+    bool exists() const { return type != FileType::NotFound; }
+
+    bool isFile() const { return type == FileType::Regular; }
+
+    bool isDirectory() const { return type == FileType::Directory; }
+
+    bool isSymlink() const { return type == FileType::Symlink; }
+};
 
-/// @brief Concatenate two paths.
-/// @note Based on the string operation, not actual file system.
-inline String pathcat(const String& path1, const String& path2)
+/// @brief The files with the same contents.
+struct DuplicateGroup
 {
-    return path1 + PREFERRED_PATH_SEPARATOR + path2;
-}
+    /// @brief The size in bytes of each file.
+    size_t size = 0;
+    /// @brief The paths of the files, at least two different files (the hardlinks of a file are all included).
+    Strings paths;
+    /// @brief The status of each path when the duplicates are found (before the contents are hashed),
+    /// the deduplicate() skips the files changed since then (by the inode, mtime and ctime).
+    /// @note It can be empty (e.g. the groups made by the user), then the contents are compared before replacing.
+    Vec<FileStatus> stats;
+};
 
-/// @brief Concatenate multiple paths.
-/// @note Based on the string operation, not actual file system.
-template <typename... Args>
-String pathcat(const String& path1, const String& path2, Args&&... paths)
+/// @brief The way to replace the duplicate files by the deduplicate().
+enum class DedupMethod
 {
-    if (sizeof...(paths) == 0)
-        return pathcat(path1, path2);
-    else
-        return pathcat(pathcat(path1, path2), std::forward<Args>(paths)...);
-}
+    /// @brief Replace the duplicate by a hardlink of the first file of the group (the files must be in a same device).
+    Hardlink,
+    /// @brief Share the data extents with the first file of the group, the files are still independent
+    /// (just supported by the filesystems with the reflink, e.g. Btrfs and XFS in Linux).
+    Reflink
+};
 
-inline String intersect(const String& base, const String& path)
+/// @brief The result of the deduplicate().
+struct DedupReport
 {
-    String result;
-    String mid;
-    size_t len = std::min(base.size(), path.size());
+    /// @brief The count of the files replaced (or would be replaced in the dry run).
+    size_t replacedCount = 0;
+    /// @brief The bytes reclaimed (estimated for the reflink, the extents shared already are unknown).
+    size_t reclaimedBytes = 0;
+    /// @brief The files failed to replace (include the files changed since the duplicates found).
+    Strings failedPaths;
+};
 
-    if (len == 0)
-        return result;
-    else
-        len--;
+/// @brief The order to read the files by the batch operations, e.g. the loadFiles() and findDuplicates().
+/// Reading by the physical layout saves the seeks of the rotational storage (and the round trips of the network
+/// storage), it's several times faster for the cold cache, but the files are located before reading.
+enum class ReadOrder
+{
+    /// @brief The order given (or the internal order of the operation), the files are not located.
+    Listing,
+    /// @brief By the device and inode number (by a stat of each file),
+    /// the inodes are allocated near the data in the most filesystems (e.g. ext4 and XFS).
+    Inode,
+    /// @brief By the device and physical offset of the first extent (by the FIEMAP in Linux),
+    /// the files without the known extents (e.g. the network filesystems) are sorted by the inode after the others.
+    Physical
+};
 
-    for (size_t i = 0; i <= len; ++i)
-    {
-        if (base[i] != path[i])
-            break;
+/// @brief The usage of the I/O buffers, the size of each usage is tunable by the setBufferSize().
+enum class BufferUsage
+{
+    /// @brief The stream reads, e.g. the File::operator<<(IStream&) and File::fromDiskPath().
+    Read,
+    /// @brief The chunks of the file copies (the read/write fallback of the copy_file_range(),
+    /// and the granularity of the cancellation).
+    Copy
+};
 
-        if (path[i] == WIN_PATH_SEPARATOR || path[i] == POSIX_PATH_SEPARATOR || i == len)
-        {
-            if (result.empty())
-                result = mid;
-            else
-                result = pathcat(result, mid);
-            mid.clear();
+/// @brief The contents of the files loaded into the arena blocks, by the loadFiles().
+/// A block is never reallocated after the contents appended, so the arena never copies the loaded contents.
+struct LoadedFiles
+{
+    Strings blocks;
+    /// @brief The block, offset in the block and size of the contents of each file.
+    Vec<size_t> blockIndices;
+    Vec<size_t> offsets;
+    Vec<size_t> sizes;
+    /// @brief The error of each file, the contents of the failed file are empty.
+    Vec<std::error_code> errors;
 
-            continue;
-        }
+    size_t count() const { return sizes.size(); }
 
-        mid += path[i];
+    const char* data(size_t index) const
+    {
+        return sizes[index] == 0 ? "" : blocks[blockIndices[index]].data() + offsets[index];
     }
 
-    return result;
-}
+    size_t size(size_t index) const { return sizes[index]; }
 
-inline String subtract(const String& base, const String& path)
+    String str(size_t index) const { return String(data(index), size(index)); }
+};
+
+/// @brief The token to cancel the long running operations, the copies share a same state,
+/// so keep a copy to cancel and pass a copy to the operations.
+/// The operations check it between the entries and between the chunks of the file data.
+class CancelToken
 {
-    if (path.empty())
-        return path;
+public:
+    using Clock = std::chrono::steady_clock;
 
-    String temp = intersect(base, path);
-    if (temp.empty())
-        return path;
+    CancelToken() : state_(std::make_shared<State_>()) {}
 
-    size_t pos = temp.size() + 2;
-    if (pos >= path.size())
-        return "";
+    /// @brief The token is cancelled automatically at the deadline.
+    explicit CancelToken(Clock::time_point deadline) : CancelToken() { state_->deadline = deadline; }
 
-    return path.substr(pos);
-}
+    /// @brief The token is cancelled automatically after the timeout from now.
+    static CancelToken after(Clock::duration timeout) { return CancelToken(Clock::now() + timeout); }
 
-/// @brief Check if the filename is valid.
-// (not empty, not ".", "..", and not contain invalid characters)
-/// @note Invalid characters: \/:*?\"<>| in windows, and / in Linux and MacOS.
-/// @note Based on the string operation, not actual file system.
-inline bool isValidFilename(const String& filename)
-{
-    // Filename can't be empty.
-    if (filename.empty())
-        return false;
+    void cancel() const { state_->isCancelled = true; }
 
-    // Filename can't be "." or "..".
-    if (filename == "." || filename == "..")
-        return false;
+    bool isCancelled() const
+    {
+        if (state_->isCancelled.load(std::memory_order_relaxed))
+            return true;
+
+        if (state_->deadline != Clock::time_point::max() && Clock::now() >= state_->deadline)
+        {
+            state_->isCancelled = true;
+            return true;
+        }
 
-    // Filename can't contain invalid characters.
-    if (filename.find_first_of(FILENAME_INVALID_CHARS) != String::npos)
         return false;
+    }
 
-    return true;
-}
+    Clock::time_point deadline() const { return state_->deadline; }
 
-/// @brief Quote the path with double quotes.
-/// @note Based on the string operation, not actual file system.
-inline String quotePath(const String& path)
+private:
+    struct State_
+    {
+        std::atomic<bool> isCancelled{ false };
+        Clock::time_point deadline = Clock::time_point::max();
+    };
+
+    std::shared_ptr<State_> state_;
+};
+
+/// @brief The statistics of the cancellable operations.
+struct OperationStats
 {
-    return "\"" + path + "\"";
+    /// @brief The count of the entries processed.
+    size_t entries  = 0;
+    /// @brief The bytes of the file data processed (read, copied or summed).
+    size_t bytes    = 0;
+    /// @brief The count of the entries failed (skipped).
+    size_t errors   = 0;
+    /// @brief If the operation is cancelled (the results are partial).
+    bool isCancelled = false;
+    std::chrono::nanoseconds elapsed{ 0 };
+};
+
+/// @brief The memory usage (in bytes) of the in-memory file structure.
+struct MemoryUsage
+{
+    /// @brief The bytes of the file data.
+    size_t contents = 0;
+    /// @brief The heap bytes of the name strings.
+    size_t names    = 0;
+    /// @brief The bytes of the File and Dir node structures and their containers.
+    size_t nodes    = 0;
+    /// @brief The allocated but unused capacity of the strings and vectors.
+    size_t slack    = 0;
+
+    size_t total() const { return contents + names + nodes + slack; }
+
+    MemoryUsage& operator+=(const MemoryUsage& other)
+    {
+        contents += other.contents;
+        names    += other.names;
+        nodes    += other.nodes;
+        slack    += other.slack;
+        return *this;
+    }
+};
+
+} // namespace wfs
+
+// Path view.
+namespace wfs
+{
+
+/// @brief Check if the character is a path separator.
+/// @note The backslash is a path separator just in windows.
+constexpr bool _isSeparator(char ch)
+{
+#ifdef _WIN32
+    return ch == WIN_PATH_SEPARATOR || ch == POSIX_PATH_SEPARATOR;
+#else
+    return ch == POSIX_PATH_SEPARATOR;
+#endif // _WIN32
 }
 
-template <typename T>
-String _fmt(const String& fmt, const T& arg)
+class PathIterator;
+
+/// @brief The non-owning view of a path string.
+/// All the operations are based on the string operation and allocation-free,
+/// the results are the views into the viewed string.
+/// @note The viewed string must outlive the view and all the views got from it.
+class PathView
 {
-    std::stringstream ss;
+public:
+    static constexpr size_t npos = size_t(-1);
+
+    constexpr PathView() = default;
 
-    if (fmt.size() < 4)
+    constexpr PathView(const char* data, size_t size) : data_(data), size_(size) {}
+
+    _WRAPPED_FILESYS_CONSTEXPR14 PathView(const char* cstr) : data_(cstr), size_(0)
     {
-        size_t pos = fmt.find("{}");
-        if (pos == String::npos)
-            return fmt;
+        while (cstr && cstr[size_] != '\0')
+            ++size_;
+    }
+
+    PathView(const String& str) : data_(str.data()), size_(str.size()) {}
+
+#ifdef _WRAPPED_FILESYS_CPP17
+    constexpr PathView(std::string_view str) : data_(str.data()), size_(str.size()) {}
+
+    constexpr operator std::string_view() const { return std::string_view(data_, size_); }
+#endif // _WRAPPED_FILESYS_CPP17
+
+    constexpr const char* data() const { return data_; }
 
-        ss << fmt.substr(0, pos);
-        ss << arg;
+    constexpr size_t size() const { return size_; }
 
-        return ss.str() + fmt.substr(pos + 2);
+    constexpr bool empty() const { return size_ == 0; }
+
+    constexpr char operator[](size_t pos) const { return data_[pos]; }
+
+    constexpr char front() const { return data_[0]; }
+
+    constexpr char back() const { return data_[size_ - 1]; }
+
+    String str() const { return empty() ? String() : String(data_, size_); }
+
+    explicit operator String() const { return str(); }
+
+    _WRAPPED_FILESYS_CONSTEXPR14 PathView substr(size_t pos, size_t count = npos) const
+    {
+        if (pos > size_)
+            pos = size_;
+        if (count > size_ - pos)
+            count = size_ - pos;
+        return PathView(data_ + pos, count);
     }
 
-    String window(4, '\0');
-    for (size_t i = 0; i < fmt.size();)
+    /// @return The size of the root name (e.g. "C:" in windows), 0 if the path has not root name.
+    /// @note The root name is always empty in non-windows platforms.
+    _WRAPPED_FILESYS_CONSTEXPR14 size_t rootNameSize() const
     {
-        window[0] = fmt[i];
-        window[1] = i < fmt.size() - 1 ? fmt[i + 1] : '\0';
-        window[2] = i < fmt.size() - 2 ? fmt[i + 2] : '\0';
-        window[3] = i < fmt.size() - 3 ? fmt[i + 3] : '\0';
+#ifdef _WIN32
+        // The drive, e.g. "C:".
+        if (size_ >= 2 && data_[1] == ':' &&
+            ((data_[0] >= 'a' && data_[0] <= 'z') || (data_[0] >= 'A' && data_[0] <= 'Z')))
+            return 2;
 
-        if (window == "{{}}")
+        // The network name, e.g. "\\server".
+        if (size_ >= 3 && _isSeparator(data_[0]) && _isSeparator(data_[1]) && !_isSeparator(data_[2]))
         {
-            ss << "{}";
-            i += 4;
-            continue;
+            size_t pos = 2;
+            while (pos < size_ && !_isSeparator(data_[pos]))
+                ++pos;
+            return pos;
         }
+#endif // _WIN32
 
-        if (window[0] == '{' && window[1] == '}')
-        {
-            ss << arg;
-            return ss.str() + fmt.substr(i + 2);
-        }
-        else
-        {
-            ss << window[0];
-            i += 1;
-            continue;
-        }
+        return 0;
     }
 
-    return ss.str();
-}
+    /// @return The position of the last character of the root (root name and root directory) plus one,
+    /// 0 if the path has not root.
+    _WRAPPED_FILESYS_CONSTEXPR14 size_t rootSize() const
+    {
+        size_t pos = rootNameSize();
+        while (pos < size_ && _isSeparator(data_[pos]))
+            ++pos;
+        return pos;
+    }
 
-template <typename T, typename... Args>
-String _fmt(const String& fmt, const T& arg, Args&&... args)
-{
-    std::stringstream ss;
+    /// @brief Get the root (root name and root directory) of the path.
+    // @example "/path/to"   -> "/"
+    // @example "C:/path/to" -> "C:/" (in windows)
+    // @example "path/to"    -> ""
+    _WRAPPED_FILESYS_CONSTEXPR14 PathView rootPath() const { return substr(0, rootSize()); }
 
-    if (fmt.size() < 4)
+    /// @brief Get the path without the root.
+    // @example "/path/to"   -> "path/to"
+    // @example "C:/path/to" -> "path/to" (in windows)
+    _WRAPPED_FILESYS_CONSTEXPR14 PathView relativePath() const { return substr(rootSize()); }
+
+    /// @brief Check if the path is a absolute path.
+    /// (Has the root directory, and has the root name in windows.)
+    _WRAPPED_FILESYS_CONSTEXPR14 bool isAbsolute() const
     {
-        size_t pos = fmt.find("{}");
-        if (pos == String::npos)
-            return fmt;
+        size_t rootName = rootNameSize();
+#ifdef _WIN32
+        if (rootName == 0)
+            return false;
+#endif // _WIN32
+        return rootName < size_ && _isSeparator(data_[rootName]);
+    }
 
-        ss << fmt.substr(0, pos);
-        ss << arg;
+    _WRAPPED_FILESYS_CONSTEXPR14 bool isRelative() const { return !isAbsolute(); }
+
+    /// @brief Get the path of the parent directory.
+    /// @note Same as the parentPath() function.
+    _WRAPPED_FILESYS_CONSTEXPR14 PathView parentPath() const
+    {
+        size_t root = rootSize();
+        if (root == size_)
+            return *this;
+
+        size_t pos = size_;
+        // Skip the filename (if the path is end with separator, the filename is empty).
+        while (pos > root && !_isSeparator(data_[pos - 1]))
+            --pos;
+        // Skip the separators between the parent path and the filename.
+        while (pos > root && _isSeparator(data_[pos - 1]))
+            --pos;
+
+        // The parent is the root, it is the root name with single root directory separator.
+        if (pos == root)
+        {
+            size_t rootName = rootNameSize();
+            return substr(0, root > rootName ? rootName + 1 : rootName);
+        }
 
-        return ss.str() + fmt.substr(pos + 2);
+        return substr(0, pos);
     }
 
-    String window(4, '\0');
-    for (size_t i = 0; i < fmt.size();)
+    /// @brief Get the parent directory name.
+    /// @note Same as the parentName() function.
+    _WRAPPED_FILESYS_CONSTEXPR14 PathView parentName() const { return parentPath().filenameEx(); }
+
+    /// @brief Get the filename with extension of the path.
+    /// @note Same as the filenameEx() function.
+    _WRAPPED_FILESYS_CONSTEXPR14 PathView filenameEx() const
     {
-        window[0] = fmt[i];
-        window[1] = i < fmt.size() - 1 ? fmt[i + 1] : '\0';
-        window[2] = i < fmt.size() - 2 ? fmt[i + 2] : '\0';
-        window[3] = i < fmt.size() - 3 ? fmt[i + 3] : '\0';
+        size_t root = rootSize();
+        size_t pos = size_;
+        while (pos > root && !_isSeparator(data_[pos - 1]))
+            --pos;
 
-        if (window == "{{}}") 
-        {
-            ss << "{}";
-            i += 4;
-            continue;
-        }
+        return substr(pos);
+    }
 
-        if (window[0] == '{' && window[1] == '}')
-        {
-            ss << arg;
-            return ss.str() + _fmt(fmt.substr(i + 2), std::forward<Args>(args)...);
-        }
-        else
-        {
-            ss << window[0];
-            i += 1;
-            continue;
-        }
+    /// @brief Get the filename not with extension of the path.
+    /// @note Same as the filename() function.
+    _WRAPPED_FILESYS_CONSTEXPR14 PathView filename() const
+    {
+        PathView name = filenameEx();
+        size_t pos = name.extensionPos_();
+        return pos == npos ? name : name.substr(0, pos);
     }
 
-    return ss.str();
-}
+    /// @brief Get the extension of the path.
+    /// @note Same as the extension() function.
+    _WRAPPED_FILESYS_CONSTEXPR14 PathView extension() const
+    {
+        PathView name = filenameEx();
+        size_t pos = name.extensionPos_();
+        return pos == npos ? PathView(name.data_ + name.size_, 0) : name.substr(pos);
+    }
 
-} // namespace wfs
+    /// @return The iterator of the first name of the path.
+    /// @note The iteration is over the names between the separators, the root directory and the empty names
+    /// (continuous separators and the trailing separator) are skipped.
+    // @example "/path//to/file.ext/" -> "path", "to", "file.ext"
+    _WRAPPED_FILESYS_CONSTEXPR14 PathIterator begin() const;
 
-#ifdef _WRAPPED_FILESYS_CPP17
-    #ifndef WFS_FWD
-        #include <filesystem>
-        namespace wfs
-        {
+    _WRAPPED_FILESYS_CONSTEXPR14 PathIterator end() const;
 
-        namespace fs = std::filesystem;
+    _WRAPPED_FILESYS_CONSTEXPR14 bool operator==(PathView other) const
+    {
+        if (size_ != other.size_)
+            return false;
 
-        }
-    #endif // !WFS_FWD
-#else
-    #ifndef WFS_FWD
-        #include <ghc/filesystem.hpp>
-        namespace wfs
+        for (size_t i = 0; i < size_; ++i)
         {
+            if (data_[i] != other.data_[i])
+                return false;
+        }
 
-        namespace fs = ghc::filesystem;
+        return true;
+    }
 
-        }
-    #endif // !WFS_FWD
-#endif // _WRAPPED_FILESYS_CPP17
+    _WRAPPED_FILESYS_CONSTEXPR14 bool operator!=(PathView other) const { return !(*this == other); }
 
-// Declaration of utility functions with filesystem.
-namespace wfs
+private:
+    /// @return The position of the extension's dot of the filename, npos if the filename has not extension.
+    _WRAPPED_FILESYS_CONSTEXPR14 size_t extensionPos_() const
+    {
+        // The "." and ".." have not extension.
+        if (size_ == 1 && data_[0] == '.')
+            return npos;
+        if (size_ == 2 && data_[0] == '.' && data_[1] == '.')
+            return npos;
+
+        size_t pos = size_;
+        while (pos > 0 && data_[pos - 1] != '.')
+            --pos;
+
+        // The filename like ".ext" has not extension.
+        return pos <= 1 ? npos : pos - 1;
+    }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/// @brief The iterator of the names of the path.
+class PathIterator
 {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = PathView;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const PathView*;
+    using reference         = const PathView&;
 
-#ifndef WFS_IMPL
+    constexpr PathIterator() = default;
 
-/// @return The normalized path.
-/// @note Based on the string operation, not actual file system.
-// @example "C:\\\\path\/to/////file.ext" -> "C:/path/to/file.ext"
-// @example "C:/path/to/subpath/"         -> "C:/path/to/subpath/"
-// @example "C:/path/to/subpath"          -> "C:/path/to/subpath"
-WFS_API String normalize(const String& path);
+    _WRAPPED_FILESYS_CONSTEXPR14 PathIterator(const char* pos, const char* end) : end_(end) { seek_(pos); }
 
-/// @return The current path.
-WFS_API String currentPath();
+    constexpr reference operator*() const { return name_; }
 
-/// @brief Get the path of the parent directory.
-/// @note Based on the string operation, not actual file system.
-// @example "C:/path/to/file.ext" -> "C:/path/to"
-// @example "C:/path/to/"         -> "C:/path/to"
-// @example "C:/path/to"          -> "C:/path"
-// @example "file.ext"            -> ""
-WFS_API String parentPath(const String& path);
+    constexpr pointer operator->() const { return &name_; }
 
-/// @brief Get the parent directory name.
-/// @note Based on the string operation, not actual file system.
-// @example "C:/path/to/file.ext" -> "to"
-// @example "C:/path/to/"         -> "to"
-// @example "C:/path/to"          -> "path"
-// @example "file.ext"            -> ""
-WFS_API String parentName(const String& path);
+    _WRAPPED_FILESYS_CONSTEXPR14 PathIterator& operator++()
+    {
+        seek_(name_.data() + name_.size());
+        return *this;
+    }
 
-/// @brief Get the filename with extension of the path.
-/// @note Based on the string operation, not actual file system.
-// @example "C:/path/to/file.ext" -> "file.ext"
-// @example "C:/path/to/"         -> ""
-// @example "C:/path/to"          -> "to"
-// @example "file.ext"            -> "file.ext"
-// @example ".ext"                -> ".ext"
-WFS_API String filenameEx(const String& path);
+    _WRAPPED_FILESYS_CONSTEXPR14 PathIterator operator++(int)
+    {
+        PathIterator temp = *this;
+        ++*this;
+        return temp;
+    }
 
-/// @brief Get the filename not with extension of the path.
-/// @note Based on the string operation, not actual file system.
-// @example "C:/path/to/file.ext" -> "file"
-// @example "C:/path/to/"         -> ""
-// @example "C:/path/to"          -> "to"
-// @example "file.ext"            -> "file"
-// @example ".ext"                -> ".ext"
-WFS_API String filename(const String& path);
+    constexpr bool operator==(const PathIterator& other) const { return name_.data() == other.name_.data(); }
 
-/// @brief Get the extension of the path.
-/// @note Based on the string operation, not actual file system.
-// @example "C:/path/to/file.ext" -> ".ext"
-// @example "C:/path/to/"         -> ""
-// @example "C:/path/to"          -> "to"
-// @example "file.ext"            -> ".ext"
-// @example ".ext"                -> ""
-WFS_API String extension(const String& path);
+    constexpr bool operator!=(const PathIterator& other) const { return name_.data() != other.name_.data(); }
 
-/// @brief Check the path if is exists.
-WFS_API bool isExists(const String& path);
+private:
+    /// @brief Seek to the next name start from the position.
+    _WRAPPED_FILESYS_CONSTEXPR14 void seek_(const char* pos)
+    {
+        while (pos != end_ && _isSeparator(*pos))
+            ++pos;
 
-/// @brief Check if the path is a file.
-/// @return If the path is exists and path target is a regular file return true, else return false.
-WFS_API bool isFile(const String& path);
+        const char* last = pos;
+        while (last != end_ && !_isSeparator(*last))
+            ++last;
 
-/// @brief Check if the path is a directory.
-/// @return If the path is exists and path target is a directory return true, else return false.
-WFS_API bool isDirectory(const String& path);
+        name_ = PathView(pos, static_cast<size_t>(last - pos));
+    }
 
-/// @brief Check if the path is a symlink.
-/// @return If the path is exists and path target is a symlink return true, else return false.
-WFS_API bool isSymlink(const String& path);
+    PathView name_;
+    const char* end_ = nullptr;
+};
 
-/// @brief Check if the path is a empty file or directory.
-/// @return If the path is a empty file or directory return true, else return false.
-/// @note If the path is not exists, throw exception.
-WFS_API bool isEmpty(const String& path);
+_WRAPPED_FILESYS_CONSTEXPR14 PathIterator PathView::begin() const
+{
+    return PathIterator(data_ + rootNameSize(), data_ + size_);
+}
 
-/// @brief Check if the path is a sub path of the base path.
-/// @note Based on the string operation, not actual file system.
-// @example "C:/path/to/file.ext", "C:/path"           -> true
-// @example "C:/path/to/subpath", "C:/path"            -> true
-// @example "C:/path/to/subpath", "C:/path/to"         -> true
-// @example "C:/path/to/subpath", "C:/path/to/"        -> true
-// @example "C:/path/to/subpath", "C:/path/to/subpath" -> false
-// @example "C:/path/to", "C:/path/to/subpath"         -> false
-WFS_API bool isSubPath(const String& path, const String& base);
+_WRAPPED_FILESYS_CONSTEXPR14 PathIterator PathView::end() const
+{
+    return PathIterator(data_ + size_, data_ + size_);
+}
 
-/// @brief Check if the path is a relative path.
-WFS_API bool isRelative(const String& path);
+} // namespace wfs
 
-/// @brief Check if the path is a absolute path.
-WFS_API bool isAbsolute(const String& path);
+// Utility functions with not filesystem.
+namespace wfs
+{
 
-/// @brief Get the relative path from the base path.
-WFS_API String relative(const String& path, const String& base = currentPath());
+inline void _append(String& buffer, PathView path)
+{
+    if (!path.empty())
+        buffer.append(path.data(), path.size());
+}
 
-/// @brief Get the absolute path.
-WFS_API String absolute(const String& path);
+inline size_t _pathsLength() { return 0; }
 
-/// @brief Check if two paths is equal.
-// @example "C:/path/to/file.ext", "C:/path/to/file.ext"     -> true
-// @example "./path/to/file.ext", "./path/to/../to/file.ext" -> true
-WFS_API bool isEqualPath(const String& path1, const String& path2);
+/// @return The length of the paths with a leading separator for each path.
+template <typename... Args>
+size_t _pathsLength(PathView path, const Args&... paths)
+{
+    return 1 + path.size() + _pathsLength(paths...);
+}
 
-/// @brief Check if filesystem entity (file, directory, symlink, hardlink) of two paths is same one.
-WFS_API bool isSameFileSystemEntity(const String& path1, const String& path2);
+inline void _pathsAppend(String&) {}
 
-/// @return The size of the file or directory.
-WFS_API size_t sizes(const String& path);
+/// @brief Append the paths to the buffer with a leading separator for each path.
+template <typename... Args>
+void _pathsAppend(String& buffer, PathView path, const Args&... paths)
+{
+    buffer.push_back(PREFERRED_PATH_SEPARATOR);
+    _append(buffer, path);
+    _pathsAppend(buffer, paths...);
+}
 
-/// @brief Create a directory.
-/// @return If the directory is existed return false.
-/// @note The parent directory must exists.
-WFS_API bool createDirectory(const String& path);
+/// @brief Concatenate multiple paths with the preferred separator.
+/// @note Based on the string operation, not actual file system.
+/// @note The arguments can be the String, C-string, PathView (and std::string_view in C++17),
+/// the result is allocated once.
+// @example "C:/path", "to", "file.ext" -> "C:/path/to/file.ext"
+template <typename... Args>
+String pathcat(PathView path1, PathView path2, const Args&... paths)
+{
+    String result;
+    result.reserve(path1.size() + _pathsLength(path2, paths...));
 
-/// @brief Create a directory tree.
-/// @return If the directory is existed return false.
-/// @note The parent directory can be not exists (create it automatically).
-WFS_API bool createDirectorys(const String& path);
+    _append(result, path1);
+    _pathsAppend(result, path2, paths...);
 
-/// @brief Delete a file.
-/// @return If the file is deleted return true, else return false.
-WFS_API bool deleteFile(const String& path);
+    return result;
+}
 
-/// @brief Recursive delete a file or directory.
-/// @return The count of the file deleted.
-WFS_API size_t deletes(const String& path);
+/// @brief Concatenate multiple paths with the preferred separator, and append it to the buffer.
+/// If the buffer is not empty, a separator is inserted between the buffer and the paths.
+/// @return The buffer.
+/// @note Based on the string operation, not actual file system.
+/// @note The buffer is reserved once, so the reused buffer (e.g. cleared in a loop) is not reallocated.
+// @example "C:/path", "to", "file.ext" -> "C:/path" + "/" + "to/file.ext"
+// @example "", "to", "file.ext"        -> "to/file.ext"
+template <typename... Args>
+String& pathcatTo(String& buffer, PathView path, const Args&... paths)
+{
+    size_t size = path.size() + _pathsLength(paths...) + (buffer.empty() ? 0 : 1);
+    buffer.reserve(buffer.size() + size);
 
-/// @brief Copy a file.
-WFS_API void copyFile(const String& src, const String& dst, bool isOverwrite = false);
+    if (!buffer.empty())
+        buffer.push_back(PREFERRED_PATH_SEPARATOR);
+    _append(buffer, path);
+    _pathsAppend(buffer, paths...);
 
-/// @brief Copy a file or directory.
-WFS_API void copys(const String& src, const String& dst, bool isOverwrite = false);
+    return buffer;
+}
 
-/// @brief Copy a symlink.
-WFS_API void copySymlink(const String& src, const String& dst);
+/// @return The position of the first path separator in [pos, size) of the data, size if not found.
+inline size_t _findSeparator(const char* data, size_t pos, size_t size)
+{
+#ifdef _WRAPPED_FILESYS_SSE2
+    const __m128i posixSep = _mm_set1_epi8(POSIX_PATH_SEPARATOR);
+    #ifdef _WIN32
+        const __m128i winSep = _mm_set1_epi8(WIN_PATH_SEPARATOR);
+    #endif // _WIN32
 
-/// @brief Move a file or directory.
-WFS_API void moves(const String& src, const String& dst);
+    for (; pos + 16 <= size; pos += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i match = _mm_cmpeq_epi8(chunk, posixSep);
+    #ifdef _WIN32
+        match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, winSep));
+    #endif // _WIN32
+
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(match));
+        if (mask != 0)
+        {
+    #ifdef _MSC_VER
+            unsigned long index = 0;
+            _BitScanForward(&index, mask);
+            return pos + index;
+    #else
+            return pos + static_cast<size_t>(__builtin_ctz(mask));
+    #endif // _MSC_VER
+        }
+    }
+#endif // _WRAPPED_FILESYS_SSE2
 
-WFS_API void reFilename(const String& path, const String& newFilename);
+    while (pos < size && !_isSeparator(data[pos]))
+        ++pos;
 
-WFS_API void reFilenameEx(const String& path, const String& newFilenameEx);
+    return pos;
+}
 
-WFS_API void reExtension(const String& path, const String& newExtension);
+constexpr bool _isDot(const char* name, size_t size) { return size == 1 && name[0] == '.'; }
 
-/// @brief Create a symlink for the file or directory.
-WFS_API void createSymlink(const String& src, const String& dst);
+constexpr bool _isDotDot(const char* name, size_t size) { return size == 2 && name[0] == '.' && name[1] == '.'; }
 
-WFS_API String symlinkTarget(const String& path);
+/// @brief Check if the path is normalized, i.e. normalize() returns the path as is.
+/// @note Based on the string operation, not actual file system.
+inline bool isNormalized(PathView path)
+{
+    if (path.empty() || _isDot(path.data(), path.size()))
+        return true;
 
-WFS_API void createHardlink(const String& src, const String& dst);
+    const char* data = path.data();
+    size_t size = path.size();
+    size_t pos = path.rootNameSize();
 
-WFS_API size_t hardlinkCount(const String& path);
+    for (size_t i = 0; i < pos; ++i)
+    {
+        if (_isSeparator(data[i]) && data[i] != PREFERRED_PATH_SEPARATOR)
+            return false;
+    }
 
-WFS_API String tempDirectory();
+    bool hasRootDir = pos < size && _isSeparator(data[pos]);
+    if (hasRootDir)
+    {
+        if (data[pos] != PREFERRED_PATH_SEPARATOR)
+            return false;
+        ++pos;
+    }
 
-/// @return The pair of the files and drietorys.
-WFS_API std::pair<Strings, Strings>
-getAlls(const String& path, bool isRecursive = true, bool (*filter)(const String&) = nullptr);
+    // The ".." is allowed just as the leading names of the relative path.
+    bool isDotDotAllowed = !hasRootDir;
 
-WFS_API Strings getAllFiles(const String& path, bool isRecursive = true, bool (*filter)(const String&) = nullptr);
+    while (pos < size)
+    {
+        size_t last = _findSeparator(data, pos, size);
+        size_t len = last - pos;
 
-WFS_API Strings getAllDirectorys(const String& path, bool isRecursive = true, bool (*filter)(const String&) = nullptr);
+        // Continuous separators.
+        if (len == 0)
+            return false;
 
-#endif // !WFS_IMPL
+        if (_isDot(data + pos, len))
+            return false;
 
-} // namespace wfs
+        if (_isDotDot(data + pos, len))
+        {
+            // The trailing separator after ".." is removed.
+            if (!isDotDotAllowed || last + 1 == size)
+                return false;
+        }
+        else
+        {
+            isDotDotAllowed = false;
+        }
 
-// Implementation of utility functions with filesystem.
-namespace wfs
-{
+        if (last == size)
+            break;
 
-#ifndef WFS_FWD
+        if (data[last] != PREFERRED_PATH_SEPARATOR)
+            return false;
+        pos = last + 1;
+    }
 
-WFS_API String normalize(const String& path)
-{
-    return fs::path(path).lexically_normal().string();
+    return true;
 }
 
-WFS_API String currentPath()
+/// @brief Normalize the path into the buffer, the original content of the buffer is discarded.
+/// The path can be a view of the buffer itself, then the path is normalized in place.
+/// @return The buffer.
+/// @note Based on the string operation, not actual file system.
+/// @note Same as the normalize() function, but the buffer can be reused to avoid the allocation.
+inline String& normalizeTo(String& buffer, PathView path)
 {
-    return fs::current_path().string();
-}
+    if (path.empty())
+    {
+        buffer.clear();
+        return buffer;
+    }
 
-WFS_API String parentPath(const String& path)
-{
-    return fs::path(path).parent_path().string();
-}
+    const char* in = path.data();
+    size_t size = path.size();
 
-WFS_API String parentName(const String& path)
-{
-    return fs::path(path).parent_path().filename().string();
-}
+    bool isAlias = in >= buffer.data() && in < buffer.data() + buffer.size();
+    if (!isAlias)
+        buffer.resize(size);
 
-WFS_API String filenameEx(const String& path)
-{
-    return fs::path(path).filename().string();
-}
+    // The output never longer than the input and the writing position never exceeds the reading position,
+    // so the output can be written in place.
+    char* out = &buffer[0];
 
-WFS_API String filename(const String& path)
-{
-    return fs::path(path).filename().replace_extension().string();
-}
+    if (isNormalized(path))
+    {
+        if (out != in)
+            std::memmove(out, in, size);
+        buffer.resize(size);
+        return buffer;
+    }
 
-WFS_API String extension(const String& path)
-{
-    return fs::path(path).extension().string();
-}
+    size_t len = 0;
+    size_t pos = path.rootNameSize();
 
-WFS_API bool isExists(const String& path)
-{
-    return fs::exists(path);
-}
+    for (size_t i = 0; i < pos; ++i)
+        out[len++] = _isSeparator(in[i]) ? PREFERRED_PATH_SEPARATOR : in[i];
 
-WFS_API bool isFile(const String& path)
-{
-    return fs::exists(path) && fs::is_regular_file(path);
-}
+    bool hasRootDir = pos < size && _isSeparator(in[pos]);
+    if (hasRootDir)
+        out[len++] = PREFERRED_PATH_SEPARATOR;
 
-WFS_API bool isDirectory(const String& path)
-{
-    return fs::exists(path) && fs::is_directory(path);
-}
+    // The size of the root in the output.
+    const size_t base = len;
+    // The count of the names in the output.
+    size_t names = 0;
+    // The output is end with a separator after a name.
+    bool isTrailing = false;
 
-WFS_API bool isSymlink(const String& path)
-{
-    return fs::is_symlink(path);
-}
+    // The start position of the last name in the output.
+    auto lastName = [&]() -> size_t
+    {
+        size_t i = isTrailing ? len - 1 : len;
+        while (i > base && out[i - 1] != PREFERRED_PATH_SEPARATOR)
+            --i;
+        return i;
+    };
 
-WFS_API bool isEmpty(const String& path)
-{
-    return fs::is_empty(path);
+    while (true)
+    {
+        size_t start = pos;
+        while (start < size && _isSeparator(in[start]))
+            ++start;
+
+        if (start == size)
+        {
+            // The trailing separator after a name is kept.
+            if (start > pos && names > 0 && !isTrailing)
+            {
+                out[len++] = PREFERRED_PATH_SEPARATOR;
+                isTrailing = true;
+            }
+            break;
+        }
+
+        pos = _findSeparator(in, start, size);
+        size_t nameSize = pos - start;
+
+        if (_isDot(in + start, nameSize))
+        {
+            if (names > 0 && !isTrailing)
+            {
+                out[len++] = PREFERRED_PATH_SEPARATOR;
+                isTrailing = true;
+            }
+        }
+        else if (_isDotDot(in + start, nameSize))
+        {
+            if (names == 0)
+            {
+                // The ".." after the root directory is removed.
+                if (!hasRootDir)
+                {
+                    out[len++] = '.';
+                    out[len++] = '.';
+                    names = 1;
+                }
+                continue;
+            }
+
+            size_t last = lastName();
+            size_t lastSize = (isTrailing ? len - 1 : len) - last;
+
+            if (_isDotDot(out + last, lastSize))
+            {
+                if (!isTrailing)
+                    out[len++] = PREFERRED_PATH_SEPARATOR;
+                out[len++] = '.';
+                out[len++] = '.';
+                ++names;
+                isTrailing = false;
+            }
+            else
+            {
+                // Remove the last name and keep the separator before it.
+                len = last;
+                --names;
+                isTrailing = names > 0;
+            }
+        }
+        else
+        {
+            if (names > 0 && !isTrailing)
+                out[len++] = PREFERRED_PATH_SEPARATOR;
+
+            std::memmove(out + len, in + start, nameSize);
+            len += nameSize;
+            ++names;
+            isTrailing = false;
+        }
+    }
+
+    // The trailing separator after ".." is removed.
+    if (isTrailing)
+    {
+        size_t last = lastName();
+        if (_isDotDot(out + last, len - 1 - last))
+            --len;
+    }
+
+    if (len == 0)
+        return buffer.assign(1, '.');
+
+    buffer.resize(len);
+    return buffer;
 }
 
-WFS_API bool isSubPath(const String& path, const String& base)
+/// @brief Normalize the multiple paths.
+/// @note Based on the string operation, not actual file system.
+inline Strings normalizes(const Strings& paths)
 {
-    String _path = normalize(absolute(path));
-    String _base = normalize(absolute(base));
+    Strings result(paths.size());
 
-    if (_path == _base)
-        return false;
-    return _path.substr(0, _base.size()) == _base;
+    for (size_t i = 0; i < paths.size(); ++i)
+        normalizeTo(result[i], paths[i]);
+
+    return result;
 }
 
-WFS_API bool isRelative(const String& path)
+/// @return The root name with the single root directory separator (if has) of the path, used as the key of the root.
+_WRAPPED_FILESYS_CONSTEXPR14 PathView _rootKey(PathView path)
 {
-    return fs::path(path).is_relative();
+    size_t size = path.rootNameSize();
+    if (size < path.size() && _isSeparator(path[size]))
+        ++size;
+    return path.substr(0, size);
 }
 
-WFS_API bool isAbsolute(const String& path)
+/// @brief Compare two names (the different path separators are treated as same).
+/// @return Negative if lhs < rhs, 0 if lhs == rhs, positive if lhs > rhs.
+_WRAPPED_FILESYS_CONSTEXPR14 int _compareName(PathView lhs, PathView rhs)
 {
-    return fs::path(path).is_absolute();
+    size_t len = lhs.size() < rhs.size() ? lhs.size() : rhs.size();
+
+    for (size_t i = 0; i < len; ++i)
+    {
+        unsigned char ch1 = static_cast<unsigned char>(_isSeparator(lhs[i]) ? PREFERRED_PATH_SEPARATOR : lhs[i]);
+        unsigned char ch2 = static_cast<unsigned char>(_isSeparator(rhs[i]) ? PREFERRED_PATH_SEPARATOR : rhs[i]);
+        if (ch1 != ch2)
+            return ch1 < ch2 ? -1 : 1;
+    }
+
+    return lhs.size() == rhs.size() ? 0 : (lhs.size() < rhs.size() ? -1 : 1);
 }
 
-WFS_API String relative(const String& path, const String& base)
+/// @return The size of the common ancestor of two paths in the path, 0 if no common ancestor.
+inline size_t _commonAncestorSize(PathView base, PathView path)
 {
-    return fs::relative(path, base).string();
+    PathView root = _rootKey(path);
+    if (_compareName(_rootKey(base), root) != 0)
+        return 0;
+
+    size_t size = root.size();
+    PathIterator it1 = base.begin();
+    PathIterator it2 = path.begin();
+
+    for (; it1 != base.end() && it2 != path.end() && *it1 == *it2; ++it1, ++it2)
+        size = static_cast<size_t>(it2->data() - path.data()) + it2->size();
+
+    return size;
 }
 
-WFS_API String absolute(const String& path)
+/// @brief Get the common ancestor of two paths.
+/// @note Based on the string operation (by names), not actual file system.
+// @example "C:/path/to/file.ext", "C:/path/to/subpath" -> "C:/path/to"
+// @example "/path/to/file.ext", "/path/subpath"        -> "/path"
+// @example "/path/to/file.ext", "/subpath"             -> "/"
+// @example "path/to/file.ext", "subpath"               -> ""
+inline String intersect(const String& base, const String& path)
 {
-    return fs::path(path).string();
+    return path.substr(0, _commonAncestorSize(base, path));
 }
 
-WFS_API bool isEqualPath(const String& path1, const String& path2)
+/// @brief Get the remaining part of the path after the common ancestor with the base.
+/// @return The path itself if no common ancestor.
+/// @note Based on the string operation (by names), not actual file system.
+// @example "C:/path", "C:/path/to/file.ext"  -> "to/file.ext"
+// @example "C:/path/to", "C:/path/file.ext"  -> "file.ext"
+// @example "subpath", "path/to/file.ext"     -> "path/to/file.ext"
+inline String subtract(const String& base, const String& path)
 {
-    String _path1 = normalize(absolute(path1));
-    String _path2 = normalize(absolute(path2));
+    size_t pos = _commonAncestorSize(base, path);
+    if (pos == 0)
+        return path;
 
-    return _path1 == _path2;
-}
+    while (pos < path.size() && _isSeparator(path[pos]))
+        ++pos;
 
-WFS_API bool isSameFileSystemEntity(const String& path1, const String& path2)
-{
-    return fs::equivalent(path1, path2);
+    return path.substr(pos);
 }
 
-WFS_API size_t sizes(const String& path)
+/// @brief The table of the invalid characters in filename (include the '\0', and the control characters in windows).
+struct _FilenameCharTable
 {
-    if (isFile(path))
+    _FilenameCharTable()
     {
-        return fs::file_size(path);
+        for (const char* ch = FILENAME_INVALID_CHARS; *ch != '\0'; ++ch)
+            isInvalid[static_cast<unsigned char>(*ch)] = true;
+
+        isInvalid[0] = true;
+#ifdef _WIN32
+        for (int ch = 1; ch < 32; ++ch)
+            isInvalid[ch] = true;
+#endif // _WIN32
     }
-    else if (isDirectory(path))
-    {
-        size_t rslt = 0;
-        for (const auto& var : fs::recursive_directory_iterator(path))
-            rslt += (var.is_regular_file() ? var.file_size() : 0);
 
-        return rslt;
+    bool isInvalid[256] = {};
+};
+
+/// @return The position of the first invalid character of the filename, size if not found.
+inline size_t _findInvalidFilenameChar(const char* data, size_t size)
+{
+    static const _FilenameCharTable table;
+    size_t pos = 0;
+
+#ifdef _WRAPPED_FILESYS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i slash = _mm_set1_epi8('/');
+    #ifdef _WIN32
+        const __m128i control = _mm_set1_epi8(0x1F);
+    #endif // _WIN32
+
+    for (; pos + 16 <= size; pos += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i match = _mm_or_si128(_mm_cmpeq_epi8(chunk, zero), _mm_cmpeq_epi8(chunk, slash));
+    #ifdef _WIN32
+        // The control characters (<= 0x1F) and the \:*?"<>|.
+        match = _mm_or_si128(match, _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+        for (const char* ch = FILENAME_INVALID_CHARS; *ch != '\0'; ++ch)
+            match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(*ch)));
+    #endif // _WIN32
+
+        if (_mm_movemask_epi8(match) != 0)
+            break;
     }
-    else
+#endif // _WRAPPED_FILESYS_SSE2
+
+    for (; pos < size; ++pos)
     {
-        throw Exception(_fmt("The specified path not exists. \"{}\"", path));
+        if (table.isInvalid[static_cast<unsigned char>(data[pos])])
+            return pos;
     }
-}
 
-WFS_API bool createDirectory(const String& path)
-{
-    return fs::create_directory(path);
+    return size;
 }
 
-WFS_API bool createDirectorys(const String& path)
+/// @brief Check if the filename is the reserved name in windows (case-insensitive, with or without extension),
+/// e.g. "CON", "nul.txt", "COM1".
+inline bool _isReservedFilename(PathView filename)
 {
-    return fs::create_directories(path);
-}
+    size_t len = 0;
+    while (len < filename.size() && filename[len] != '.')
+        ++len;
 
-WFS_API bool deleteFile(const String& path)
-{
-    return fs::remove(path);
-}
+    auto upper = [&](size_t i) -> char
+    {
+        char ch = filename[i];
+        return (ch >= 'a' && ch <= 'z') ? static_cast<char>(ch - 'a' + 'A') : ch;
+    };
 
-WFS_API size_t deletes(const String& path)
-{
-    return fs::remove_all(path);
+    auto isName = [&](const char* name) -> bool
+    {
+        return upper(0) == name[0] && upper(1) == name[1] && upper(2) == name[2];
+    };
+
+    if (len == 3)
+        return isName("CON") || isName("PRN") || isName("AUX") || isName("NUL");
+
+    if (len == 4 && filename[3] >= '1' && filename[3] <= '9')
+        return isName("COM") || isName("LPT");
+
+    return false;
 }
 
-WFS_API void copyFile(const String& src, const String& dst, bool isOverwrite)
+/// @brief Check if the filename is valid.
+// (not empty, not ".", "..", and not contain invalid characters)
+/// @param isCheckReserved If true, also check the reserved names in windows ("CON", "NUL", "COM1", etc.)
+/// and the trailing dot or space (which are invalid in windows), for the portable filenames in all platforms.
+/// @note Invalid characters: \/:*?\"<>| and the control characters in windows, and / in Linux and MacOS.
+/// (The '\0' is invalid in all platforms.)
+/// @note Based on the string operation, not actual file system.
+inline bool isValidFilename(PathView filename, bool isCheckReserved = false)
 {
-    auto copyOptions = isOverwrite ? fs::copy_options::overwrite_existing : fs::copy_options::skip_existing;
-    fs::copy_file(src, dst, copyOptions);
-}
+    // Filename can't be empty.
+    if (filename.empty())
+        return false;
 
-WFS_API void copys(const String& src, const String& dst, bool isOverwrite)
-{
-    auto copyOptions = isOverwrite ? fs::copy_options::overwrite_existing : fs::copy_options::skip_existing;
-    copyOptions |= fs::copy_options::recursive;
-    fs::copy(src, dst, copyOptions);
-}
+    // Filename can't be "." or "..".
+    if (_isDot(filename.data(), filename.size()) || _isDotDot(filename.data(), filename.size()))
+        return false;
 
-WFS_API void copySymlink(const String& src, const String& dst)
-{
-    fs::copy_symlink(src, dst);
-}
+    // Filename can't contain invalid characters.
+    if (_findInvalidFilenameChar(filename.data(), filename.size()) != filename.size())
+        return false;
 
-WFS_API void moves(const String& src, const String& dst)
-{
-    fs::rename(src, dst);
-}
+    if (isCheckReserved)
+    {
+        if (filename.back() == '.' || filename.back() == ' ')
+            return false;
 
-WFS_API void reFilename(const String& path, const String& newFilename)
-{
-    auto dst = pathcat(parentPath(path), newFilename + extension(path));
-    moves(path, dst);
-}
+        if (_isReservedFilename(filename))
+            return false;
+    }
 
-WFS_API void reFilenameEx(const String& path, const String& newFilenameEx)
-{
-    auto dst = pathcat(parentPath(path), newFilenameEx);
-    moves(path, dst);
+    return true;
 }
 
-WFS_API void reExtension(const String& path, const String& newExtension)
+/// @brief Check the multiple filenames.
+/// @return The indexes of the invalid filenames.
+/// @note Based on the string operation, not actual file system.
+inline Vec<size_t> invalidFilenames(const Strings& filenames, bool isCheckReserved = false)
 {
-    auto dst = pathcat(parentPath(path), filename(path) + newExtension);
-    moves(path, dst);
-}
+    Vec<size_t> rslt;
 
-WFS_API void createSymlink(const String& src, const String& dst)
-{
-    if (isFile(src))
-        fs::create_symlink(src, dst);
-    else if (isDirectory(src))
-        fs::create_directory_symlink(src, dst);
-    else
-        throw Exception(_fmt("The specified path not exists. \"{}\"", src));
-}
+    for (size_t i = 0; i < filenames.size(); ++i)
+    {
+        if (!isValidFilename(filenames[i], isCheckReserved))
+            rslt.push_back(i);
+    }
 
-WFS_API String symlinkTarget(const String& path)
-{
-    return fs::read_symlink(path).string();
+    return rslt;
 }
 
-WFS_API void createHardlink(const String& src, const String& dst)
+/// @return The heap bytes held by the string (0 if the string is stored inline by SSO).
+inline size_t _heapBytes(const String& str)
 {
-    fs::create_hard_link(src, dst);
+    static const size_t inlineCapacity = String().capacity();
+    return str.capacity() > inlineCapacity ? str.capacity() + 1 : 0;
 }
 
-WFS_API size_t hardlinkCount(const String& path)
+/// @brief Add the memory usage of the name string to the usage.
+inline void _accountName(MemoryUsage& usage, const String& name)
 {
-    return fs::hard_link_count(path);
-}
+    // The short name is stored inline of the string object by SSO.
+    if (_heapBytes(name) == 0)
+        return;
 
-WFS_API String tempDirectory()
-{
-    return fs::temp_directory_path().string();
+    usage.names += name.size();
+    usage.slack += _heapBytes(name) - name.size();
 }
 
-WFS_API std::pair<Strings, Strings>
-getAlls(const String& path, bool isRecursive, bool (*filter)(const String&))
+/// @brief Quote the path with double quotes.
+/// @note Based on the string operation, not actual file system.
+inline String quotePath(const String& path)
 {
-    if (!isDirectory(path))
-        throw Exception(_fmt("The specified path is not directory or not exists. \"{}\"", path));
+    return "\"" + path + "\"";
+}
 
-    Strings files;
-    Strings dirs;
+/// @brief Not constexpr, is called in the immediate function to report the count of the placeholders
+/// and the arguments of the _fmt() are mismatched at compile time.
+inline void _fmtArgCountMismatch() {}
 
-    if (isRecursive)
+/// @brief The format string of the _fmt(), the placeholders are "{}" and the "{{}}" is the escape of the "{}".
+/// The format string is parsed at compile time in C++20 (and the count of the placeholders is checked),
+/// so the formatting just needs to write the pieces.
+template <size_t ArgCount>
+class _FmtString
+{
+public:
+    template <size_t N>
+    _WRAPPED_FILESYS_CONSTEVAL _FmtString(const char (&str)[N]) : data_(str), size_(N - 1)
     {
-        for (const auto& var : fs::recursive_directory_iterator(path))
+        for (size_t i = 0; i < size_;)
         {
-            String _path = var.path().string();
-
-            if (var.is_regular_file() && (!filter || filter(_path)))
-                files.push_back(_path);
-
-            if (var.is_directory() && (!filter || filter(_path)))
-                dirs.push_back(_path);
+            if (isEscape(i))
+            {
+                literalSize_ += 2;
+                i += 4;
+            }
+            else if (isPlaceholder(i))
+            {
+                ++placeholders_;
+                i += 2;
+            }
+            else
+            {
+                ++literalSize_;
+                ++i;
+            }
         }
+
+#ifdef _WRAPPED_FILESYS_CONSTEVAL_ENABLED
+        // Call a non-constexpr function to raise a compile error.
+        if (placeholders_ != ArgCount)
+            _fmtArgCountMismatch();
+#endif // _WRAPPED_FILESYS_CONSTEVAL_ENABLED
     }
-    else
-    {
-        for (const auto& var : fs::directory_iterator(path))
-        {
-            String _path = var.path().string();
 
-            if (var.is_regular_file() && (!filter || filter(_path)))
-                files.push_back(_path);
+    constexpr const char* data() const { return data_; }
 
-            if (var.is_directory() && (!filter || filter(_path)))
-                dirs.push_back(_path);
-        }
+    constexpr size_t size() const { return size_; }
+
+    /// @return The size of the result without the arguments.
+    constexpr size_t literalSize() const { return literalSize_; }
+
+    constexpr size_t placeholders() const { return placeholders_; }
+
+    constexpr bool isEscape(size_t pos) const
+    {
+        return pos + 4 <= size_ && data_[pos] == '{' && data_[pos + 1] == '{' &&
+               data_[pos + 2] == '}' && data_[pos + 3] == '}';
     }
 
-    return { files, dirs };
-}
+    constexpr bool isPlaceholder(size_t pos) const
+    {
+        return pos + 2 <= size_ && data_[pos] == '{' && data_[pos + 1] == '}';
+    }
 
-WFS_API Strings getAllFiles(const String& path, bool isRecursive, bool (*filter)(const String&))
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t literalSize_ = 0;
+    size_t placeholders_ = 0;
+};
+
+/// @brief The argument of the _fmt() converted to the characters without iostreams
+/// (except the types that just can be written by the ostream).
+class _FmtArg
 {
-    if (!isDirectory(path))
-        throw Exception(_fmt("The specified path is not directory or not exists. \"{}\"", path));
+public:
+    _FmtArg(const String& str) : data_(str.data()), size_(str.size()) {}
 
-    Strings files;
+    _FmtArg(const char* str) : data_(str), size_(str ? std::strlen(str) : 0) {}
 
-    if (isRecursive)
+    _FmtArg(PathView str) : data_(str.data()), size_(str.size()) {}
+
+    _FmtArg(char ch) : size_(1), isInline_(true) { buffer_[0] = ch; }
+
+    _FmtArg(bool value) : _FmtArg(value ? "1" : "0") {}
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    _FmtArg(T value) : isInline_(true)
     {
-        for (const auto& var : fs::recursive_directory_iterator(path))
+        // Write the digits from the end of the buffer.
+        char* last = buffer_ + sizeof(buffer_);
+        char* first = last;
+
+        bool isNegative = value < 0;
+        auto abs = static_cast<typename std::make_unsigned<T>::type>(value);
+        if (isNegative)
+            abs = 0 - abs;
+
+        do
         {
-            String _path = var.path().string();
-            if (var.is_regular_file() && (!filter || filter(_path)))
-                files.push_back(_path);
-        }
+            *--first = static_cast<char>('0' + abs % 10);
+            abs /= 10;
+        } while (abs != 0);
+
+        if (isNegative)
+            *--first = '-';
+
+        size_ = static_cast<size_t>(last - first);
+        std::memmove(buffer_, first, size_);
     }
-    else
+
+    template <typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+    _FmtArg(T value) : isInline_(true)
     {
-        for (const auto& var : fs::directory_iterator(path))
-        {
-            String _path = var.path().string();
-            if (var.is_regular_file() && (!filter || filter(_path)))
-                files.push_back(_path);
-        }
+        // Same as the default format of the ostream.
+        int len = std::snprintf(buffer_, sizeof(buffer_), "%g", static_cast<double>(value));
+        size_ = len < 0 ? 0 : std::min(static_cast<size_t>(len), sizeof(buffer_) - 1);
     }
 
-    return files;
-}
+    template <typename T, typename std::enable_if<!std::is_arithmetic<T>::value &&
+                                                  !std::is_convertible<const T&, PathView>::value, int>::type = 0>
+    _FmtArg(const T& value)
+    {
+        std::ostringstream oss;
+        oss << value;
+        owned_ = oss.str();
+        data_ = owned_.data();
+        size_ = owned_.size();
+    }
 
-WFS_API Strings getAllDirectorys(const String& path, bool isRecursive, bool (*filter)(const String&))
+    _FmtArg(const _FmtArg&) = delete;
+
+    _FmtArg& operator=(const _FmtArg&) = delete;
+
+    const char* data() const { return isInline_ ? buffer_ : data_; }
+
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool isInline_ = false;
+    char buffer_[32] = {};
+    String owned_;
+};
+
+/// @brief Format the string with the arguments, the result is allocated once.
+/// @note The placeholders that have not corresponding arguments are kept as is.
+template <size_t ArgCount>
+String _vfmt(const _FmtString<ArgCount>& fmt, const _FmtArg* const* args)
 {
-    if (!isDirectory(path))
-        throw Exception(_fmt("The specified path is not directory or not exists. \"{}\"", path));
+    size_t size = fmt.literalSize();
+    for (size_t i = 0; i < fmt.placeholders(); ++i)
+        size += i < ArgCount ? args[i]->size() : 2;
 
-    Strings dirs;
+    String result;
+    result.reserve(size);
 
-    if (isRecursive)
+    size_t index = 0;
+    for (size_t i = 0; i < fmt.size();)
     {
-        for (const auto& var : fs::recursive_directory_iterator(path))
+        if (fmt.isEscape(i))
         {
-            String _path = var.path().string();
-            if (var.is_directory() && (!filter || filter(_path)))
-                dirs.push_back(_path);
+            result.append("{}", 2);
+            i += 4;
         }
-    }
-    else
-    {
-        for (const auto& var : fs::directory_iterator(path))
+        else if (fmt.isPlaceholder(i))
         {
-            String _path = var.path().string();
-            if (var.is_directory() && (!filter || filter(_path)))
-                dirs.push_back(_path);
+            if (index < ArgCount)
+                result.append(args[index]->data(), args[index]->size());
+            else
+                result.append("{}", 2);
+
+            ++index;
+            i += 2;
+        }
+        else
+        {
+            result.push_back(fmt.data()[i]);
+            ++i;
         }
     }
 
-    return dirs;
+    return result;
 }
 
-#endif // !WFS_FWD
+template <size_t ArgCount, typename... FmtArgs>
+String _fmtArgs(const _FmtString<ArgCount>& fmt, const FmtArgs&... args)
+{
+    // The first element is a placeholder to avoid the zero-length array.
+    const _FmtArg* argv[] = { nullptr, &args... };
+    return _vfmt(fmt, argv + 1);
+}
+
+template <typename... Args>
+String _fmt(const _FmtString<sizeof...(Args)>& fmt, const Args&... args)
+{
+    return _fmtArgs(fmt, _FmtArg(args)...);
+}
 
 } // namespace wfs
 
-// Classes.
+// Path trie.
 namespace wfs
 {
 
-#ifndef WFS_IMPL
-
-class File
+/// @brief The queries of the path trie, shared by the PathTrie and the CompactPathTrie.
+/// The paths are matched by names (continuous separators and trailing separator are ignored),
+/// so the "/path/to" contains "/path/to/file.ext" but not contains "/path/toto".
+/// @note The "." and ".." are not resolved, normalize the paths before insert and query if needed.
+/// @note The Derived class must provide:
+// size_t child_(size_t node, PathView name) const; (The index of the child node, npos if not exists.)
+// size_t base_(size_t node) const;                 (The index of the base end at the node, npos if not a base.)
+// (The index of the root node is 0.)
+template <typename Derived>
+class _PathTrieQuery
 {
 public:
-    File() = default;
+    static constexpr size_t npos = size_t(-1);
 
-    ~File() { releaseData(); }
+    /// @return The index of the outermost base which contains the path (include the path itself),
+    /// npos if no base contains the path.
+    size_t findBase(PathView path) const { return match_(path, true, nullptr); }
 
-    File(const File& other)
+    /// @return The index of the innermost base which contains the path (include the path itself),
+    /// npos if no base contains the path.
+    size_t longestPrefix(PathView path) const { return match_(path, false, nullptr); }
+
+    /// @brief Check if any base contains the path (include the path itself).
+    bool contains(PathView path) const { return findBase(path) != npos; }
+
+    /// @return The deepest ancestor of the path which is also an ancestor (or itself) of any base.
+    /// The result is a view into the path.
+    // @example "/path/to/file.ext" with the bases "/path/to/subpath" and "/other" -> "/path/to"
+    PathView commonAncestor(PathView path) const
     {
-        name_ = other.name_;
-        if (other.data_)
-            data_ = new String(*other.data_);
+        size_t size = 0;
+        match_(path, false, &size);
+        return path.substr(0, size);
     }
 
-    File(File&& other) noexcept
+    /// @brief The batch version of the findBase().
+    Vec<size_t> findBases(const Strings& paths) const
     {
-        name_ = other.name_;
-        data_ = other.data_;
-        other.data_ = nullptr;
+        Vec<size_t> result;
+        result.reserve(paths.size());
+
+        for (const auto& var : paths)
+            result.push_back(findBase(var));
+
+        return result;
     }
 
-    File& operator=(const File& other)
+    /// @brief The batch version of the longestPrefix().
+    Vec<size_t> longestPrefixes(const Strings& paths) const
     {
-        name_ = other.name_;
+        Vec<size_t> result;
+        result.reserve(paths.size());
 
-        releaseData();
-        if (other.data_)
-            data_ = new String(*other.data_);
+        for (const auto& var : paths)
+            result.push_back(longestPrefix(var));
 
-        return *this;
+        return result;
+    }
+
+private:
+    size_t match_(PathView path, bool isOutermost, size_t* matchedSize) const
+    {
+        const Derived& trie = static_cast<const Derived&>(*this);
+
+        PathView root = _rootKey(path);
+        size_t node = trie.child_(0, root);
+        size_t size = 0;
+        size_t result = npos;
+
+        if (node != npos)
+        {
+            size = root.size();
+            result = trie.base_(node);
+
+            for (auto it = path.begin(); it != path.end() && !(isOutermost && result != npos); ++it)
+            {
+                node = trie.child_(node, *it);
+                if (node == npos)
+                    break;
+
+                size = static_cast<size_t>(it->data() - path.data()) + it->size();
+                if (trie.base_(node) != npos)
+                    result = trie.base_(node);
+            }
+        }
+
+        if (matchedSize)
+            *matchedSize = size;
+
+        return result;
+    }
+};
+
+template <typename Derived>
+constexpr size_t _PathTrieQuery<Derived>::npos;
+
+class CompactPathTrie;
+
+/// @brief The trie of the base paths by names, for the bulk containment and common ancestor queries.
+/// The time of a query is proportional to the depth of the path (and logarithmic to the count of the siblings).
+class PathTrie : public _PathTrieQuery<PathTrie>
+{
+public:
+    PathTrie() : nodes_(1) {}
+
+    explicit PathTrie(const Strings& bases) : nodes_(1)
+    {
+        for (const auto& var : bases)
+            insert(var);
+    }
+
+    /// @brief Insert a base path.
+    /// @return The index of the base (by the insertion order), if the path is already inserted,
+    /// return the index of the existed one.
+    size_t insert(PathView path)
+    {
+        size_t node = child_(0, _rootKey(path), true);
+        for (const auto& var : path)
+            node = child_(node, var, true);
+
+        if (nodes_[node].base == npos)
+        {
+            nodes_[node].base = bases_.size();
+            bases_.push_back(path.str());
+        }
+
+        return nodes_[node].base;
+    }
+
+    /// @return The count of the bases.
+    size_t size() const { return bases_.size(); }
+
+    bool empty() const { return bases_.empty(); }
+
+    const Strings& bases() const { return bases_; }
+
+    const String& base(size_t index) const { return bases_[index]; }
+
+    void clear()
+    {
+        nodes_.assign(1, Node_());
+        bases_.clear();
     }
 
-    explicit File(const String& name) { setName(name); }
+    /// @return The immutable compact form of the trie, with the names stored in a single buffer
+    /// and the children stored contiguously.
+    CompactPathTrie compact() const;
+
+private:
+    friend class _PathTrieQuery<PathTrie>;
+    friend class CompactPathTrie;
+
+    struct Node_
+    {
+        String name;
+        size_t base = npos;
+        // The indexes of the children nodes, sorted by names.
+        Vec<size_t> children;
+    };
+
+    size_t base_(size_t node) const { return nodes_[node].base; }
+
+    size_t child_(size_t node, PathView name) const
+    {
+        const auto& children = nodes_[node].children;
+        auto it = lowerBound_(children, name);
+
+        if (it != children.end() && _compareName(nodes_[*it].name, name) == 0)
+            return *it;
+
+        return npos;
+    }
+
+    size_t child_(size_t node, PathView name, bool isCreate)
+    {
+        size_t rslt = child_(node, name);
+        if (rslt != npos || !isCreate)
+            return rslt;
+
+        rslt = nodes_.size();
+        nodes_.push_back(Node_());
+        nodes_.back().name = name.str();
+
+        auto& children = nodes_[node].children;
+        children.insert(lowerBound_(children, name), rslt);
+
+        return rslt;
+    }
+
+    Vec<size_t>::const_iterator lowerBound_(const Vec<size_t>& children, PathView name) const
+    {
+        return std::lower_bound(children.begin(), children.end(), name,
+                                [this](size_t index, PathView key) { return _compareName(nodes_[index].name, key) < 0; });
+    }
+
+    Vec<Node_> nodes_;
+    Strings bases_;
+};
+
+/// @brief The immutable compact form of the PathTrie.
+class CompactPathTrie : public _PathTrieQuery<CompactPathTrie>
+{
+public:
+    CompactPathTrie() : nodes_(1) {}
+
+    explicit CompactPathTrie(const PathTrie& trie)
+    {
+        bases_ = trie.bases_;
+
+        // Breadth-first, so the children of a node are stored contiguously and keep the sorted order.
+        Vec<size_t> order(1, 0);
+        nodes_.reserve(trie.nodes_.size());
+
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            const auto& node = trie.nodes_[order[i]];
+
+            Node_ compactNode;
+            compactNode.nameOffset = names_.size();
+            compactNode.nameSize = node.name.size();
+            compactNode.firstChild = order.size();
+            compactNode.childCount = node.children.size();
+            compactNode.base = node.base;
+
+            names_ += node.name;
+            nodes_.push_back(compactNode);
+            order.insert(order.end(), node.children.begin(), node.children.end());
+        }
+    }
+
+    size_t size() const { return bases_.size(); }
+
+    bool empty() const { return bases_.empty(); }
+
+    const Strings& bases() const { return bases_; }
+
+    const String& base(size_t index) const { return bases_[index]; }
+
+private:
+    friend class _PathTrieQuery<CompactPathTrie>;
+
+    struct Node_
+    {
+        size_t nameOffset = 0;
+        size_t nameSize = 0;
+        size_t firstChild = 0;
+        size_t childCount = 0;
+        size_t base = npos;
+    };
+
+    PathView name_(size_t node) const { return PathView(names_.data() + nodes_[node].nameOffset, nodes_[node].nameSize); }
+
+    size_t base_(size_t node) const { return nodes_[node].base; }
+
+    size_t child_(size_t node, PathView name) const
+    {
+        size_t first = nodes_[node].firstChild;
+        size_t last = first + nodes_[node].childCount;
+
+        while (first < last)
+        {
+            size_t mid = first + (last - first) / 2;
+            int cmp = _compareName(name_(mid), name);
+
+            if (cmp == 0)
+                return mid;
+            if (cmp < 0)
+                first = mid + 1;
+            else
+                last = mid;
+        }
+
+        return npos;
+    }
+
+    String names_;
+    Vec<Node_> nodes_;
+    Strings bases_;
+};
+
+inline CompactPathTrie PathTrie::compact() const { return CompactPathTrie(*this); }
+
+} // namespace wfs
+
+// Path hashing and hash containers.
+namespace wfs
+{
+
+/// @return The 128-bit product of the a and b as the (low, high) in the a and b.
+inline void _wymum(uint64_t& a, uint64_t& b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    a = static_cast<uint64_t>(r);
+    b = static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t ha = a >> 32, hb = b >> 32, la = a & 0xFFFFFFFF, lb = b & 0xFFFFFFFF;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    a = lo;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif // __SIZEOF_INT128__
+}
+
+inline uint64_t _wymix(uint64_t a, uint64_t b)
+{
+    _wymum(a, b);
+    return a ^ b;
+}
+
+inline uint64_t _wyr8(const char* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint64_t _wyr4(const char* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint64_t _wyr3(const char* p, size_t k)
+{
+    return (uint64_t(static_cast<unsigned char>(p[0])) << 16) |
+           (uint64_t(static_cast<unsigned char>(p[k >> 1])) << 8) |
+           uint64_t(static_cast<unsigned char>(p[k - 1]));
+}
+
+/// @brief The fast non-cryptographic hash of the bytes (the wyhash algorithm, public domain).
+/// @note The result is different between little-endian and big-endian platforms, don't persist it.
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0)
+{
+    static constexpr uint64_t secret[4] = {
+        0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+    };
+
+    const char* p = static_cast<const char*>(data);
+    uint64_t a = 0;
+    uint64_t b = 0;
+
+    seed ^= _wymix(seed ^ secret[0], secret[1]);
+
+    if (size <= 16)
+    {
+        if (size >= 4)
+        {
+            a = (_wyr4(p) << 32) | _wyr4(p + ((size >> 3) << 2));
+            b = (_wyr4(p + size - 4) << 32) | _wyr4(p + size - 4 - ((size >> 3) << 2));
+        }
+        else if (size > 0)
+        {
+            a = _wyr3(p, size);
+        }
+    }
+    else
+    {
+        size_t i = size;
+
+        if (i > 48)
+        {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+
+            do
+            {
+                seed = _wymix(_wyr8(p) ^ secret[1], _wyr8(p + 8) ^ seed);
+                see1 = _wymix(_wyr8(p + 16) ^ secret[2], _wyr8(p + 24) ^ see1);
+                see2 = _wymix(_wyr8(p + 32) ^ secret[3], _wyr8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16)
+        {
+            seed = _wymix(_wyr8(p) ^ secret[1], _wyr8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+
+        a = _wyr8(p + i - 16);
+        b = _wyr8(p + i - 8);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    _wymum(a, b);
+
+    return _wymix(a ^ secret[0] ^ size, b ^ secret[1]);
+}
+
+/// @brief The fast hash of the path string (as is, not normalized).
+inline uint64_t hashPath(PathView path, uint64_t seed = 0)
+{
+    return hashBytes(path.data(), path.size(), seed);
+}
+
+/// @brief Get the normalized form of the path, the buffer is used only if the path is not normalized.
+inline PathView _normalizedView(PathView path, String& buffer)
+{
+    if (isNormalized(path))
+        return path;
+
+    normalizeTo(buffer, path);
+    return buffer;
+}
+
+/// @brief The hasher of the path string for the hash containers.
+struct PathHash
+{
+    size_t operator()(PathView path) const { return static_cast<size_t>(hashPath(path)); }
+};
+
+/// @brief The hasher of the path by the normalized form, the equivalent paths have the same hash.
+/// @note Based on the string operation (not made absolute), not actual file system.
+struct NormalizedPathHash
+{
+    size_t operator()(PathView path) const
+    {
+        String buffer;
+        return static_cast<size_t>(hashPath(_normalizedView(path, buffer)));
+    }
+};
+
+/// @brief The comparator of the paths by the normalized form.
+/// @note Based on the string operation (not made absolute), not actual file system.
+struct NormalizedPathEqual
+{
+    bool operator()(PathView path1, PathView path2) const
+    {
+        String buffer1;
+        String buffer2;
+        return _normalizedView(path1, buffer1) == _normalizedView(path2, buffer2);
+    }
+};
+
+/// @brief The hash map with the path keys, by the open addressing (linear probing).
+/// The keys are stored in a single arena buffer, and the entries are stored densely by the insertion order
+/// (an erase moves the last entry to the erased position).
+/// @note If the isNormalize is true, the keys are normalized (stored and looked up by the normalized form),
+/// so the equivalent paths are the same key.
+template <typename T>
+class PathMap
+{
+public:
+    explicit PathMap(bool isNormalize = false) : isNormalize_(isNormalize) {}
+
+    size_t size() const { return entries_.size(); }
+
+    bool empty() const { return entries_.empty(); }
+
+    bool isNormalize() const { return isNormalize_; }
+
+    void clear()
+    {
+        arena_.clear();
+        entries_.clear();
+        values_.clear();
+        slots_.clear();
+        tombstones_ = 0;
+    }
+
+    void reserve(size_t count)
+    {
+        if (count * 2 > slots_.size())
+            rehash_(count * 2);
+        entries_.reserve(count);
+        values_.reserve(count);
+    }
+
+    /// @return The key of the i-th entry (by the insertion order, the erase changes the order).
+    PathView key(size_t index) const { return PathView(arena_.data() + entries_[index].offset, entries_[index].size); }
+
+    T& value(size_t index) { return values_[index]; }
+
+    const T& value(size_t index) const { return values_[index]; }
+
+    /// @brief Insert the path with the value if the path is not exists.
+    /// @return The pair of the value of the path and if the insertion is performed.
+    std::pair<T*, bool> insert(PathView path, const T& value)
+    {
+        String buffer;
+        PathView _path = key_(path, buffer);
+        uint64_t hash = hashPath(_path);
+
+        size_t slot = find_(_path, hash);
+        if (slot != NOF_)
+            return { &values_[slots_[slot]], false };
+
+        if ((entries_.size() + tombstones_ + 1) * 2 > slots_.size())
+            rehash_(slots_.size() < 16 ? 16 : entries_.size() * 4);
+
+        slot = hash & (slots_.size() - 1);
+        while (slots_[slot] != EMPTY_ && slots_[slot] != TOMBSTONE_)
+            slot = (slot + 1) & (slots_.size() - 1);
+
+        if (slots_[slot] == TOMBSTONE_)
+            --tombstones_;
+        slots_[slot] = entries_.size();
+
+        entries_.push_back({ hash, arena_.size(), _path.size() });
+        _append(arena_, _path);
+        values_.push_back(value);
+
+        return { &values_.back(), true };
+    }
+
+    T& operator[](PathView path) { return *insert(path, T()).first; }
+
+    T* find(PathView path)
+    {
+        String buffer;
+        PathView _path = key_(path, buffer);
+        size_t slot = find_(_path, hashPath(_path));
+        return slot == NOF_ ? nullptr : &values_[slots_[slot]];
+    }
+
+    const T* find(PathView path) const { return const_cast<PathMap*>(this)->find(path); }
+
+    bool contains(PathView path) const { return find(path) != nullptr; }
+
+    /// @return If the path is exists and erased return true, else return false.
+    bool erase(PathView path)
+    {
+        String buffer;
+        PathView _path = key_(path, buffer);
+        size_t slot = find_(_path, hashPath(_path));
+        if (slot == NOF_)
+            return false;
+
+        size_t index = slots_[slot];
+        slots_[slot] = TOMBSTONE_;
+        ++tombstones_;
+
+        // Move the last entry to the erased position.
+        size_t last = entries_.size() - 1;
+        if (index != last)
+        {
+            size_t lastSlot = find_(key(last), entries_[last].hash);
+            slots_[lastSlot] = index;
+            entries_[index] = entries_[last];
+            values_[index] = std::move(values_[last]);
+        }
+
+        entries_.pop_back();
+        values_.pop_back();
+
+        return true;
+    }
+
+private:
+    static constexpr size_t NOF_        = size_t(-1);
+    static constexpr size_t EMPTY_      = size_t(-1);
+    static constexpr size_t TOMBSTONE_  = size_t(-2);
+
+    struct Entry_
+    {
+        uint64_t hash;
+        size_t offset;
+        size_t size;
+    };
+
+    PathView key_(PathView path, String& buffer) const { return isNormalize_ ? _normalizedView(path, buffer) : path; }
+
+    /// @return The slot of the path, NOF_ if not exists.
+    size_t find_(PathView path, uint64_t hash) const
+    {
+        if (slots_.empty())
+            return NOF_;
+
+        for (size_t slot = hash & (slots_.size() - 1);; slot = (slot + 1) & (slots_.size() - 1))
+        {
+            size_t index = slots_[slot];
+            if (index == EMPTY_)
+                return NOF_;
+
+            if (index != TOMBSTONE_ && entries_[index].hash == hash && key(index) == path)
+                return slot;
+        }
+    }
+
+    /// @brief Rebuild the slots with the new count (rounded up to the power of 2), and compact the arena.
+    void rehash_(size_t count)
+    {
+        size_t capacity = 16;
+        while (capacity < count)
+            capacity *= 2;
+
+        String arena;
+        arena.reserve(arena_.size());
+
+        slots_.assign(capacity, EMPTY_);
+        tombstones_ = 0;
+
+        for (size_t i = 0; i < entries_.size(); ++i)
+        {
+            size_t offset = arena.size();
+            _append(arena, key(i));
+            entries_[i].offset = offset;
+
+            size_t slot = entries_[i].hash & (capacity - 1);
+            while (slots_[slot] != EMPTY_)
+                slot = (slot + 1) & (capacity - 1);
+            slots_[slot] = i;
+        }
+
+        arena_.swap(arena);
+    }
+
+    bool isNormalize_;
+    String arena_;
+    Vec<Entry_> entries_;
+    Vec<T> values_;
+    Vec<size_t> slots_;
+    size_t tombstones_ = 0;
+};
+
+template <typename T>
+constexpr size_t PathMap<T>::NOF_;
+
+template <typename T>
+constexpr size_t PathMap<T>::EMPTY_;
+
+template <typename T>
+constexpr size_t PathMap<T>::TOMBSTONE_;
+
+/// @brief The hash set of the paths, same as the PathMap without the values.
+class PathSet
+{
+public:
+    explicit PathSet(bool isNormalize = false) : map_(isNormalize) {}
+
+    size_t size() const { return map_.size(); }
+
+    bool empty() const { return map_.empty(); }
+
+    void clear() { map_.clear(); }
+
+    void reserve(size_t count) { map_.reserve(count); }
+
+    PathView key(size_t index) const { return map_.key(index); }
+
+    /// @return If the path is not exists and inserted return true, else return false.
+    bool insert(PathView path) { return map_.insert(path, None_()).second; }
+
+    bool contains(PathView path) const { return map_.contains(path); }
+
+    bool erase(PathView path) { return map_.erase(path); }
+
+private:
+    struct None_ {};
+
+    PathMap<None_> map_;
+};
+
+} // namespace wfs
+
+// Executors.
+namespace wfs
+{
+
+/// @brief The interface of the executor which runs the tasks of the bulk operations.
+/// Implement it to run the tasks by the executor of the application, and set it by the setCpuExecutor()
+/// and setIoExecutor() or pass it to the bulk operations.
+/// @note The operations take the executor are: the absolutes(), createDirectorys(Strings),
+/// the cancellable sizes(), deletes(), copys() and getAlls() (getAllFiles(), getAllDirectorys()),
+/// findDuplicates(), deduplicate(), loadFiles() (loadFileRanges(), loadFileTails()), File::fromDiskPaths(),
+/// Dir::fromDiskPath(), FileTypeDetector::detectFiles() and the asyncXxx(). The others run in the caller thread,
+/// include the walkFiles() (the func is called in order), RealpathCache::canonicals() (bound by the cache,
+/// the hits are cheap) and the Pipeline (its stages block on the bounded queues, so each worker has a thread).
+class Executor
+{
+public:
+    using Task = std::function<void()>;
+
+    virtual ~Executor() = default;
+
+    /// @brief Run the task asynchronously.
+    virtual void submit(Task task) = 0;
+
+    /// @return The count of the tasks can run concurrently.
+    virtual size_t concurrency() const = 0;
+};
+
+/// @brief The thread pool with the work stealing.
+/// Each worker has a task queue, the tasks submitted by a worker are pushed to its own queue and
+/// popped by LIFO (the nested tasks run first and hot in the cache), and the idle workers steal by FIFO.
+/// @note The exceptions escaped from the tasks are ignored.
+class ThreadPool : public Executor
+{
+public:
+    /// @param threadCount The count of the worker threads, 0 means the hardware concurrency.
+    explicit ThreadPool(size_t threadCount = 0) :
+        threadCount_(threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threadCount),
+        queues_(new Queue_[threadCount_])
+    {
+        for (size_t i = 0; i < threadCount_; ++i)
+            threads_.emplace_back(&ThreadPool::run_, this, i);
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isStop_ = true;
+        }
+
+        cv_.notify_all();
+
+        for (auto& thread : threads_)
+            thread.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Task task) override
+    {
+        Worker_& worker = worker_();
+        size_t index = worker.pool == this ? worker.index : next_++ % threadCount_;
+
+        {
+            std::lock_guard<std::mutex> lock(queues_[index].mutex);
+            queues_[index].tasks.push_back(std::move(task));
+        }
+
+        ++pending_;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+
+        cv_.notify_one();
+    }
+
+    size_t concurrency() const override { return threadCount_; }
+
+private:
+    struct Queue_
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    struct Worker_
+    {
+        ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    static Worker_& worker_()
+    {
+        static thread_local Worker_ worker;
+        return worker;
+    }
+
+    /// @brief Pop from the back of the own queue, or steal from the other queues.
+    bool take_(size_t index, Task& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queues_[index].mutex);
+            if (!queues_[index].tasks.empty())
+            {
+                task = std::move(queues_[index].tasks.back());
+                queues_[index].tasks.pop_back();
+                --pending_;
+                return true;
+            }
+        }
+
+        return steal_(index + 1, task);
+    }
+
+    /// @brief Pop from the front of the queues, start from the index.
+    bool steal_(size_t index, Task& task)
+    {
+        for (size_t i = 0; i < threadCount_; ++i)
+        {
+            Queue_& queue = queues_[(index + i) % threadCount_];
+
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                --pending_;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static void execute_(Task& task)
+    {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {}
+    }
+
+    void run_(size_t index)
+    {
+        worker_().pool = this;
+        worker_().index = index;
+
+        while (true)
+        {
+            Task task;
+            if (take_(index, task))
+            {
+                execute_(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return isStop_ || pending_ > 0; });
+
+            if (isStop_ && pending_ == 0)
+                return;
+        }
+    }
+
+    size_t threadCount_;
+    std::unique_ptr<Queue_[]> queues_;
+    Vec<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::atomic<size_t> pending_{ 0 };
+    std::atomic<size_t> next_{ 0 };
+    bool isStop_ = false;
+};
+
+/// @brief The default executor of the CPU bound tasks (the hashing), with the hardware concurrency threads.
+inline Executor& defaultCpuExecutor()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+/// @brief The default executor of the I/O bound tasks (the syscalls), with more threads than the CPU one,
+/// so the blocking I/O can be overlapped.
+inline Executor& defaultIoExecutor()
+{
+    static ThreadPool pool(std::max<size_t>(16, 4 * std::thread::hardware_concurrency()));
+    return pool;
+}
+
+inline std::atomic<Executor*>& _cpuExecutor()
+{
+    static std::atomic<Executor*> executor(nullptr);
+    return executor;
+}
+
+inline std::atomic<Executor*>& _ioExecutor()
+{
+    static std::atomic<Executor*> executor(nullptr);
+    return executor;
+}
+
+/// @return The executor set by the setCpuExecutor(), or the default one.
+inline Executor& cpuExecutor()
+{
+    Executor* executor = _cpuExecutor();
+    return executor != nullptr ? *executor : defaultCpuExecutor();
+}
+
+/// @return The executor set by the setIoExecutor(), or the default one.
+inline Executor& ioExecutor()
+{
+    Executor* executor = _ioExecutor();
+    return executor != nullptr ? *executor : defaultIoExecutor();
+}
+
+/// @brief Set the executor used by the CPU bound tasks, nullptr to reset to the default one.
+/// @note The executor must be alive until it is reset and the operations using it are finished.
+inline void setCpuExecutor(Executor* executor)
+{
+    _cpuExecutor() = executor;
+}
+
+/// @brief Set the executor used by the I/O bound tasks, nullptr to reset to the default one.
+/// @note The executor must be alive until it is reset and the operations using it are finished.
+inline void setIoExecutor(Executor* executor)
+{
+    _ioExecutor() = executor;
+}
+
+/// @brief Call the func(i) for each i in [0, count) by the executor, the caller thread also calls until all
+/// indices are claimed, and then waits only for the calls running, so the nested parallelFor never deadlocks
+/// (even if no helper starts), and the caller never runs the other tasks of the executor.
+/// @param executor The executor to run, nullptr means the cpuExecutor().
+/// @note The first exception thrown by the func is rethrown in the caller thread, and the remaining calls are skipped.
+template <typename Func>
+void parallelFor(size_t count, Func func, Executor* executor = nullptr)
+{
+    Executor& _executor = executor != nullptr ? *executor : cpuExecutor();
+    size_t helperCount = std::min(count, _executor.concurrency()) - (count > 0 ? 1 : 0);
+
+    if (helperCount == 0)
+    {
+        for (size_t i = 0; i < count; ++i)
+            func(i);
+        return;
+    }
+
+    // The helpers may start after the caller returned, so the state is shared,
+    // and the func is called only if there is an unclaimed index (the caller is still waiting).
+    struct State
+    {
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> running{ 0 };
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    auto state = std::make_shared<State>();
+    size_t _count = count;
+    Func* _func = &func;
+
+    auto work = [state, _count, _func]()
+    {
+        while (true)
+        {
+            ++state->running;
+
+            size_t i = state->next.fetch_add(1);
+            if (i < _count)
+            {
+                try
+                {
+                    (*_func)(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (!state->error)
+                        state->error = std::current_exception();
+                    state->next = _count;
+                }
+            }
+
+            if (--state->running == 0 && state->next >= _count)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->cv.notify_all();
+            }
+
+            if (i >= _count)
+                return;
+        }
+    };
+
+    for (size_t i = 0; i < helperCount; ++i)
+        _executor.submit(work);
+
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&]() { return state->running == 0; });
+
+    // Moved out, so the exception is released by the caller, not by the helper releasing the state last.
+    std::exception_ptr error = std::move(state->error);
+    lock.unlock();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+} // namespace wfs
+
+#if defined(_WRAPPED_FILESYS_POSIX) && !defined(WFS_FWD)
+    #include <cerrno>       // errno
+    #include <fcntl.h>      // AT_FDCWD
+    #include <sys/stat.h>   // stat, statx
+    #include <unistd.h>     // close
+    #include <poll.h>       // poll
+    #include <sys/mman.h>   // mmap, madvise
+    #include <stdlib.h>     // posix_memalign
+#endif // _WRAPPED_FILESYS_POSIX && !WFS_FWD
+
+#if defined(__linux__) && !defined(WFS_FWD)
+    #include <sys/inotify.h>    // inotify_init1, inotify_add_watch
+    #include <sys/sysmacros.h>  // makedev
+    #include <sys/ioctl.h>      // ioctl
+    #include <linux/fs.h>       // FIDEDUPERANGE, FS_IOC_FIEMAP
+    #include <linux/fiemap.h>   // fiemap
+    #include <sys/syscall.h>    // syscall, __NR_io_uring_setup
+    #include <sys/uio.h>        // iovec
+    #ifdef __has_include
+        #if __has_include(<linux/io_uring.h>)
+            #include <linux/io_uring.h> // io_uring_sqe, io_uring_cqe
+        #endif // __has_include(<linux/io_uring.h>)
+    #endif // __has_include
+
+    // The io_uring with the direct descriptors (Linux 5.15+ at runtime, the headers of 5.19+ at compile time).
+    #if defined(IORING_FILE_INDEX_ALLOC) && defined(__NR_io_uring_setup)
+        #define _WRAPPED_FILESYS_IO_URING
+    #endif // IORING_FILE_INDEX_ALLOC && __NR_io_uring_setup
+#endif // __linux__ && !WFS_FWD
+
+#ifdef _WRAPPED_FILESYS_CPP17
+    #ifndef WFS_FWD
+        #include <filesystem>
+        namespace wfs
+        {
+
+        namespace fs = std::filesystem;
+
+        }
+    #endif // !WFS_FWD
+#else
+    #ifndef WFS_FWD
+        #include <ghc/filesystem.hpp>
+        namespace wfs
+        {
+
+        namespace fs = ghc::filesystem;
+
+        }
+    #endif // !WFS_FWD
+#endif // _WRAPPED_FILESYS_CPP17
+
+// Declaration of the I/O buffers.
+namespace wfs
+{
+
+#ifndef WFS_IMPL
+
+/// @return The default size of the I/O buffer of the usage for the file with the block size (the st_blksize),
+/// a multiple of the block size and at least 128 KiB (1 MiB for the copy), so the fast devices (e.g. NVMe)
+/// and the network filesystems (with the large block size) are saturated by few syscalls.
+/// @param blockSize 0 means unknown (4096).
+WFS_API size_t defaultBufferSize(BufferUsage usage, size_t blockSize = 0);
+
+/// @return The size set by the setBufferSize(), or the default size for the block size.
+WFS_API size_t bufferSize(BufferUsage usage, size_t blockSize = 0);
+
+/// @brief Set the size of the I/O buffer of the usage, 0 to reset to the default (by the block size of each file).
+WFS_API void setBufferSize(BufferUsage usage, size_t size);
+
+/// @brief Enable or disable the huge pages (MADV_HUGEPAGE) of the buffers of 2 MiB or more (enabled by default).
+/// @note Just affects the buffers allocated after it, and it's a hint (the transparent huge pages may be disabled).
+WFS_API void setHugePageBuffer(bool isEnabled);
+
+/// @brief Take an idle buffer of the size at least from the pool of the current thread, or allocate a new one.
+/// @param capacity The real size of the buffer.
+WFS_API char* _acquireBuffer(size_t size, size_t& capacity);
+
+/// @brief Give the buffer back to the pool of the current thread, or free it if the pool is full.
+WFS_API void _releaseBuffer(char* data, size_t capacity);
+
+#endif // !WFS_IMPL
+
+} // namespace wfs
+
+// Implementation of the I/O buffers.
+namespace wfs
+{
+
+#ifndef WFS_FWD
+
+/// @brief The alignment of the buffers (a page, so the buffers are usable by the direct I/O).
+constexpr size_t _BUFFER_ALIGNMENT = 4096;
+/// @brief The buffers of the size or more are mapped and aligned for the huge pages.
+constexpr size_t _HUGE_PAGE_SIZE = 2 << 20;
+/// @brief The count of the idle buffers kept by the pool of each thread.
+constexpr size_t _BUFFER_POOL_CAPACITY = 4;
+
+WFS_API std::atomic<size_t>& _bufferSizeSetting(BufferUsage usage)
+{
+    static std::atomic<size_t> sizes[2];
+    return sizes[static_cast<size_t>(usage)];
+}
+
+WFS_API std::atomic<bool>& _isHugePageBuffer()
+{
+    static std::atomic<bool> isEnabled(true);
+    return isEnabled;
+}
+
+WFS_API size_t defaultBufferSize(BufferUsage usage, size_t blockSize)
+{
+    size_t minSize = usage == BufferUsage::Copy ? (1 << 20) : (128 << 10);
+    if (blockSize == 0)
+        blockSize = 4096;
+
+    size_t size = std::max(minSize, blockSize);
+    return (size + blockSize - 1) / blockSize * blockSize;
+}
+
+WFS_API size_t bufferSize(BufferUsage usage, size_t blockSize)
+{
+    size_t size = _bufferSizeSetting(usage);
+    return size != 0 ? size : defaultBufferSize(usage, blockSize);
+}
+
+WFS_API void setBufferSize(BufferUsage usage, size_t size)
+{
+    _bufferSizeSetting(usage) = size;
+}
+
+WFS_API void setHugePageBuffer(bool isEnabled)
+{
+    _isHugePageBuffer() = isEnabled;
+}
+
+/// @param capacity The size rounded up by the _allocBufferCapacity().
+WFS_API char* _allocBuffer(size_t capacity)
+{
+#ifdef _WRAPPED_FILESYS_POSIX
+    if (capacity < _HUGE_PAGE_SIZE)
+    {
+        void* data = nullptr;
+        if (::posix_memalign(&data, _BUFFER_ALIGNMENT, capacity) != 0)
+            throw std::bad_alloc();
+        return static_cast<char*>(data);
+    }
+
+    // Map one more huge page and trim, so the buffer is aligned to the huge page.
+    size_t size = capacity + _HUGE_PAGE_SIZE;
+    void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED)
+        throw std::bad_alloc();
+
+    char* begin = static_cast<char*>(mapped);
+    char* data = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(begin) + _HUGE_PAGE_SIZE - 1) &
+                                         ~static_cast<uintptr_t>(_HUGE_PAGE_SIZE - 1));
+    if (data != begin)
+        ::munmap(begin, static_cast<size_t>(data - begin));
+    if (data + capacity != begin + size)
+        ::munmap(data + capacity, static_cast<size_t>(begin + size - data - capacity));
+
+    #ifdef MADV_HUGEPAGE
+    if (_isHugePageBuffer())
+        ::madvise(data, capacity, MADV_HUGEPAGE);
+    #endif // MADV_HUGEPAGE
+
+    return data;
+#else
+    return static_cast<char*>(::operator new(capacity));
+#endif // _WRAPPED_FILESYS_POSIX
+}
+
+WFS_API void _freeBuffer(char* data, size_t capacity)
+{
+#ifdef _WRAPPED_FILESYS_POSIX
+    if (capacity < _HUGE_PAGE_SIZE)
+        ::free(data);
+    else
+        ::munmap(data, capacity);
+#else
+    (void)capacity;
+    ::operator delete(data);
+#endif // _WRAPPED_FILESYS_POSIX
+}
+
+/// @return The size rounded up to the alignment (or the huge page if it's large).
+WFS_API size_t _allocBufferCapacity(size_t size)
+{
+    size_t alignment = size < _HUGE_PAGE_SIZE ? _BUFFER_ALIGNMENT : _HUGE_PAGE_SIZE;
+    return (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment;
+}
+
+/// @brief The idle buffers of a thread, they are freed when the thread exits.
+struct _BufferPool
+{
+    Vec<std::pair<char*, size_t>> buffers;
+
+    ~_BufferPool()
+    {
+        for (const auto& var : buffers)
+            _freeBuffer(var.first, var.second);
+    }
+};
+
+WFS_API _BufferPool& _threadBufferPool()
+{
+    static thread_local _BufferPool pool;
+    return pool;
+}
+
+WFS_API char* _acquireBuffer(size_t size, size_t& capacity)
+{
+    _BufferPool& pool = _threadBufferPool();
+
+    // The smallest idle buffer fits.
+    size_t best = pool.buffers.size();
+    for (size_t i = 0; i < pool.buffers.size(); ++i)
+    {
+        if (pool.buffers[i].second >= size && (best == pool.buffers.size() ||
+                                               pool.buffers[i].second < pool.buffers[best].second))
+        {
+            best = i;
+        }
+    }
+
+    if (best != pool.buffers.size())
+    {
+        char* data = pool.buffers[best].first;
+        capacity = pool.buffers[best].second;
+        pool.buffers.erase(pool.buffers.begin() + static_cast<ptrdiff_t>(best));
+        return data;
+    }
+
+    capacity = _allocBufferCapacity(size);
+    return _allocBuffer(capacity);
+}
+
+WFS_API void _releaseBuffer(char* data, size_t capacity)
+{
+    _BufferPool& pool = _threadBufferPool();
+
+    if (pool.buffers.size() < _BUFFER_POOL_CAPACITY)
+        pool.buffers.emplace_back(data, capacity);
+    else
+        _freeBuffer(data, capacity);
+}
+
+#endif // !WFS_FWD
+
+/// @brief The aligned I/O buffer borrowed from the pool of the current thread and given back when destroyed,
+/// so the repeated I/O of a thread reuses the buffers (and their pages are faulted once).
+/// The buffers of 2 MiB or more are backed by the huge pages if available, see the setHugePageBuffer().
+/// @note The contents are not initialized.
+class IoBuffer
+{
+public:
+    IoBuffer() = default;
+
+    explicit IoBuffer(size_t size) : size_(size) { data_ = _acquireBuffer(size, capacity_); }
+
+    ~IoBuffer() { release_(); }
+
+    IoBuffer(const IoBuffer&) = delete;
+
+    IoBuffer& operator=(const IoBuffer&) = delete;
+
+    IoBuffer(IoBuffer&& other) noexcept : data_(other.data_), size_(other.size_), capacity_(other.capacity_)
+    {
+        other.data_ = nullptr;
+        other.size_ = other.capacity_ = 0;
+    }
+
+    IoBuffer& operator=(IoBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release_();
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+            std::swap(capacity_, other.capacity_);
+        }
+
+        return *this;
+    }
+
+    char* data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+private:
+    void release_()
+    {
+        if (data_ != nullptr)
+            _releaseBuffer(data_, capacity_);
+
+        data_ = nullptr;
+        size_ = capacity_ = 0;
+    }
+
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+} // namespace wfs
+
+// Declaration of utility functions with filesystem.
+namespace wfs
+{
+
+#ifndef WFS_IMPL
+
+/// @return The normalized path.
+/// @note Based on the string operation, not actual file system.
+// @example "C:\\\\path\/to/////file.ext" -> "C:/path/to/file.ext"
+// @example "C:/path/to/subpath/"         -> "C:/path/to/subpath/"
+// @example "C:/path/to/subpath"          -> "C:/path/to/subpath"
+WFS_API String normalize(const String& path);
+
+/// @return The current path.
+WFS_API String currentPath();
+
+/// @brief Get the path of the parent directory.
+/// @note Based on the string operation, not actual file system.
+// @example "C:/path/to/file.ext" -> "C:/path/to"
+// @example "C:/path/to/"         -> "C:/path/to"
+// @example "C:/path/to"          -> "C:/path"
+// @example "file.ext"            -> ""
+WFS_API String parentPath(const String& path);
+
+/// @brief Get the parent directory name.
+/// @note Based on the string operation, not actual file system.
+// @example "C:/path/to/file.ext" -> "to"
+// @example "C:/path/to/"         -> "to"
+// @example "C:/path/to"          -> "path"
+// @example "file.ext"            -> ""
+WFS_API String parentName(const String& path);
+
+/// @brief Get the filename with extension of the path.
+/// @note Based on the string operation, not actual file system.
+// @example "C:/path/to/file.ext" -> "file.ext"
+// @example "C:/path/to/"         -> ""
+// @example "C:/path/to"          -> "to"
+// @example "file.ext"            -> "file.ext"
+// @example ".ext"                -> ".ext"
+WFS_API String filenameEx(const String& path);
+
+/// @brief Get the filename not with extension of the path.
+/// @note Based on the string operation, not actual file system.
+// @example "C:/path/to/file.ext" -> "file"
+// @example "C:/path/to/"         -> ""
+// @example "C:/path/to"          -> "to"
+// @example "file.ext"            -> "file"
+// @example ".ext"                -> ".ext"
+WFS_API String filename(const String& path);
+
+/// @brief Get the extension of the path.
+/// @note Based on the string operation, not actual file system.
+// @example "C:/path/to/file.ext" -> ".ext"
+// @example "C:/path/to/"         -> ""
+// @example "C:/path/to"          -> ""
+// @example "file.ext"            -> ".ext"
+// @example ".ext"                -> ""
+WFS_API String extension(const String& path);
+
+/// @brief Get the metadata of the filesystem entity (follow the symlink) by a single stat.
+/// @return The status with the type FileType::NotFound if the path is not exists.
+/// @note Throw exception if other error occurs.
+WFS_API FileStatus status(const String& path);
+
+/// @brief Get the metadata of the filesystem entity (not follow the symlink) by a single stat.
+/// @return The status with the type FileType::NotFound if the path is not exists.
+/// @note Throw exception if other error occurs.
+WFS_API FileStatus lstatus(const String& path);
+
+/// @brief The non-throwing version of the status().
+WFS_API FileStatus status(const String& path, std::error_code& ec);
+
+/// @brief The non-throwing version of the lstatus().
+WFS_API FileStatus lstatus(const String& path, std::error_code& ec);
+
+/// @brief Check the path if is exists.
+WFS_API bool isExists(const String& path);
+
+/// @brief Check if the path is a file.
+/// @return If the path is exists and path target is a regular file return true, else return false.
+WFS_API bool isFile(const String& path);
+
+/// @brief Check if the path is a directory.
+/// @return If the path is exists and path target is a directory return true, else return false.
+WFS_API bool isDirectory(const String& path);
+
+/// @brief Check if the path is a symlink.
+/// @return If the path is exists and path target is a symlink return true, else return false.
+WFS_API bool isSymlink(const String& path);
+
+/// @brief Check if the path is a empty file or directory.
+/// @return If the path is a empty file or directory return true, else return false.
+/// @note If the path is not exists, throw exception.
+WFS_API bool isEmpty(const String& path);
+
+/// @brief Check if the path is a sub path of the base path.
+/// @note Based on the string operation, not actual file system.
+// @example "C:/path/to/file.ext", "C:/path"           -> true
+// @example "C:/path/to/subpath", "C:/path"            -> true
+// @example "C:/path/to/subpath", "C:/path/to"         -> true
+// @example "C:/path/to/subpath", "C:/path/to/"        -> true
+// @example "C:/path/to/subpath", "C:/path/to/subpath" -> false
+// @example "C:/path/to", "C:/path/to/subpath"         -> false
+WFS_API bool isSubPath(const String& path, const String& base);
+
+/// @brief Check if the path is a relative path.
+/// @note Based on the string operation, not actual file system.
+WFS_API bool isRelative(const String& path);
+
+/// @brief Check if the path is a absolute path.
+/// @note Based on the string operation, not actual file system.
+WFS_API bool isAbsolute(const String& path);
+
+/// @return The cached current path, got at the first call or the last refreshCurrentPath() call.
+/// @note The absolute() and relative() functions are based on it, to avoid the getcwd for every call.
+WFS_API String cachedCurrentPath();
+
+/// @brief Refresh the cached current path, call it after the current path is changed.
+WFS_API void refreshCurrentPath();
+
+/// @brief Get the relative path from the base path, the paths are made absolute and normalized first.
+/// @return The empty string if the paths have different roots.
+/// @note Based on the string operation (the symlinks are not resolved), not actual file system.
+// @example "/path/to/file.ext", "/path"         -> "to/file.ext"
+// @example "/path/to/file.ext", "/path/subpath" -> "../to/file.ext"
+// @example "/path/to", "/path/to"               -> "."
+WFS_API String relative(const String& path, const String& base);
+
+/// @brief Get the relative path from the (cached) current path.
+WFS_API String relative(const String& path);
+
+/// @brief Get the relative paths of the multiple paths from a same base path.
+/// @note The base path is parsed once.
+WFS_API Strings relatives(const Strings& paths, const String& base);
+
+/// @brief Get the absolute path, the relative path is joined to the (cached) current path.
+/// @note Based on the string operation (not normalized), not actual file system.
+// @example "to/file.ext" -> "/path/to/file.ext" (the current path is "/path")
+// @example "/file.ext"   -> "/file.ext"
+WFS_API String absolute(const String& path);
+
+/// @brief Get the absolute paths of the multiple paths, the large batch is split into chunks run in parallel.
+/// @param executor The executor to run the chunks, nullptr means the cpuExecutor().
+WFS_API Strings absolutes(const Strings& paths, Executor* executor = nullptr);
+
+/// @brief Check if two paths is equal.
+// @example "C:/path/to/file.ext", "C:/path/to/file.ext"     -> true
+// @example "./path/to/file.ext", "./path/to/../to/file.ext" -> true
+WFS_API bool isEqualPath(const String& path1, const String& path2);
+
+/// @brief Check if filesystem entity (file, directory, symlink, hardlink) of two paths is same one.
+WFS_API bool isSameFileSystemEntity(const String& path1, const String& path2);
+
+/// @return The size of the file or directory.
+WFS_API size_t sizes(const String& path);
+
+/// @brief Create a directory.
+/// @return If the directory is existed return false.
+/// @note The parent directory must exists.
+WFS_API bool createDirectory(const String& path);
+
+/// @brief Create a directory tree.
+/// @return If the directory is existed return false.
+/// @note The parent directory can be not exists (create it automatically).
+WFS_API bool createDirectorys(const String& path);
+
+/// @brief Delete a file.
+/// @return If the file is deleted return true, else return false.
+WFS_API bool deleteFile(const String& path);
+
+/// @brief Recursive delete a file or directory.
+/// @return The count of the file deleted.
+WFS_API size_t deletes(const String& path);
+
+/// @brief Copy a file.
+WFS_API void copyFile(const String& src, const String& dst, bool isOverwrite = false);
+
+/// @brief Copy a file or directory.
+WFS_API void copys(const String& src, const String& dst, bool isOverwrite = false);
+
+/// @brief Copy a symlink.
+WFS_API void copySymlink(const String& src, const String& dst);
+
+/// @brief Move a file or directory.
+WFS_API void moves(const String& src, const String& dst);
+
+WFS_API void reFilename(const String& path, const String& newFilename);
+
+WFS_API void reFilenameEx(const String& path, const String& newFilenameEx);
+
+WFS_API void reExtension(const String& path, const String& newExtension);
+
+/// @brief Create a symlink for the file or directory.
+WFS_API void createSymlink(const String& src, const String& dst);
+
+WFS_API String symlinkTarget(const String& path);
+
+WFS_API void createHardlink(const String& src, const String& dst);
+
+WFS_API size_t hardlinkCount(const String& path);
+
+WFS_API String tempDirectory();
+
+/// @return The pair of the files and drietorys.
+WFS_API std::pair<Strings, Strings>
+getAlls(const String& path, bool isRecursive = true, bool (*filter)(const String&) = nullptr);
+
+WFS_API Strings getAllFiles(const String& path, bool isRecursive = true, bool (*filter)(const String&) = nullptr);
+
+WFS_API Strings getAllDirectorys(const String& path, bool isRecursive = true, bool (*filter)(const String&) = nullptr);
+
+#endif // !WFS_IMPL
+
+} // namespace wfs
+
+// Implementation of utility functions with filesystem.
+namespace wfs
+{
+
+#ifndef WFS_FWD
+
+WFS_API String normalize(const String& path)
+{
+    String result;
+    normalizeTo(result, path);
+    return result;
+}
+
+WFS_API String currentPath()
+{
+    return fs::current_path().string();
+}
+
+WFS_API String parentPath(const String& path)
+{
+    return PathView(path).parentPath().str();
+}
+
+WFS_API String parentName(const String& path)
+{
+    return PathView(path).parentName().str();
+}
+
+WFS_API String filenameEx(const String& path)
+{
+    return PathView(path).filenameEx().str();
+}
+
+WFS_API String filename(const String& path)
+{
+    return PathView(path).filename().str();
+}
+
+WFS_API String extension(const String& path)
+{
+    return PathView(path).extension().str();
+}
+
+#ifdef _WRAPPED_FILESYS_POSIX
+
+inline FileType _fileType(unsigned mode)
+{
+    if (S_ISREG(mode))
+        return FileType::Regular;
+    if (S_ISDIR(mode))
+        return FileType::Directory;
+    if (S_ISLNK(mode))
+        return FileType::Symlink;
+    if (S_ISBLK(mode))
+        return FileType::Block;
+    if (S_ISCHR(mode))
+        return FileType::Character;
+    if (S_ISFIFO(mode))
+        return FileType::Fifo;
+    if (S_ISSOCK(mode))
+        return FileType::Socket;
+    return FileType::Unknown;
+}
+
+#endif // _WRAPPED_FILESYS_POSIX
+
+WFS_API FileStatus _status(const String& path, bool isFollow, std::error_code& ec)
+{
+    FileStatus rslt;
+    ec.clear();
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+    // The statx() is not supported by the old kernels (or blocked by the seccomp of some containers),
+    // then the stat() is used instead.
+    static std::atomic<bool> isStatxUnsupported(false);
+
+    struct statx stx;
+    int flags = AT_STATX_SYNC_AS_STAT | (isFollow ? 0 : AT_SYMLINK_NOFOLLOW);
+
+    if (!isStatxUnsupported.load(std::memory_order_relaxed))
+    {
+        if (::statx(AT_FDCWD, path.c_str(), flags, STATX_BASIC_STATS, &stx) == 0)
+        {
+            rslt.type       = _fileType(stx.stx_mode);
+            rslt.size       = static_cast<size_t>(stx.stx_size);
+            rslt.blocks     = static_cast<size_t>(stx.stx_blocks);
+            rslt.blockSize  = static_cast<size_t>(stx.stx_blksize);
+            rslt.mtime      = int64_t(stx.stx_mtime.tv_sec) * 1000000000 + stx.stx_mtime.tv_nsec;
+            rslt.ctime      = int64_t(stx.stx_ctime.tv_sec) * 1000000000 + stx.stx_ctime.tv_nsec;
+            rslt.mode       = stx.stx_mode & 07777;
+            rslt.inode      = stx.stx_ino;
+            rslt.device     = static_cast<uint64_t>(makedev(stx.stx_dev_major, stx.stx_dev_minor));
+            rslt.nlink      = static_cast<size_t>(stx.stx_nlink);
+            return rslt;
+        }
+
+        if (errno != ENOSYS && errno != EPERM)
+        {
+            // The not exists is not an error.
+            if (errno != ENOENT && errno != ENOTDIR)
+                ec = std::error_code(errno, std::generic_category());
+            return rslt;
+        }
+
+        isStatxUnsupported = true;
+    }
+#endif // __linux__ && STATX_BASIC_STATS
+
+#ifdef _WRAPPED_FILESYS_POSIX
+    struct stat st;
+
+    if ((isFollow ? ::stat(path.c_str(), &st) : ::lstat(path.c_str(), &st)) == 0)
+    {
+        rslt.type       = _fileType(st.st_mode);
+        rslt.size       = static_cast<size_t>(st.st_size);
+        rslt.blocks     = static_cast<size_t>(st.st_blocks);
+        rslt.blockSize  = static_cast<size_t>(st.st_blksize);
+    #ifdef __APPLE__
+        rslt.mtime      = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+        rslt.ctime      = int64_t(st.st_ctimespec.tv_sec) * 1000000000 + st.st_ctimespec.tv_nsec;
+    #else
+        rslt.mtime      = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        rslt.ctime      = int64_t(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+    #endif // __APPLE__
+        rslt.mode       = st.st_mode & 07777;
+        rslt.inode      = static_cast<uint64_t>(st.st_ino);
+        rslt.device     = static_cast<uint64_t>(st.st_dev);
+        rslt.nlink      = static_cast<size_t>(st.st_nlink);
+        return rslt;
+    }
+
+    // The not exists is not an error.
+    if (errno != ENOENT && errno != ENOTDIR)
+        ec = std::error_code(errno, std::generic_category());
+#else
+    auto status = isFollow ? fs::status(path, ec) : fs::symlink_status(path, ec);
+
+    // The not exists is not an error, but the ec is set by the implementations (e.g. the MSVC and libstdc++).
+    if (status.type() == fs::file_type::not_found)
+        ec.clear();
+    if (ec)
+        return rslt;
+
+    switch (status.type())
+    {
+        case fs::file_type::not_found:  rslt.type = FileType::NotFound;  break;
+        case fs::file_type::regular:    rslt.type = FileType::Regular;   break;
+        case fs::file_type::directory:  rslt.type = FileType::Directory; break;
+        case fs::file_type::symlink:    rslt.type = FileType::Symlink;   break;
+        case fs::file_type::block:      rslt.type = FileType::Block;     break;
+        case fs::file_type::character:  rslt.type = FileType::Character; break;
+        case fs::file_type::fifo:       rslt.type = FileType::Fifo;      break;
+        case fs::file_type::socket:     rslt.type = FileType::Socket;    break;
+        default:                        rslt.type = FileType::Unknown;   break;
+    }
+
+    if (!rslt.exists())
+        return rslt;
+
+    // The other metadata are best effort, there is not a single call to get them.
+    std::error_code _ec;
+    rslt.mode = static_cast<unsigned>(status.permissions()) & 07777;
+
+    if (rslt.isFile())
+    {
+        auto size = fs::file_size(path, _ec);
+        rslt.size = _ec ? 0 : static_cast<size_t>(size);
+    }
+
+    auto mtime = fs::last_write_time(path, _ec);
+    if (!_ec)
+        rslt.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+
+    auto nlink = fs::hard_link_count(path, _ec);
+    rslt.nlink = _ec ? 0 : static_cast<size_t>(nlink);
+#endif // _WRAPPED_FILESYS_POSIX
+
+    return rslt;
+}
+
+WFS_API FileStatus status(const String& path, std::error_code& ec)
+{
+    return _status(path, true, ec);
+}
+
+WFS_API FileStatus lstatus(const String& path, std::error_code& ec)
+{
+    return _status(path, false, ec);
+}
+
+WFS_API FileStatus status(const String& path)
+{
+    std::error_code ec;
+    FileStatus rslt = _status(path, true, ec);
+
+    if (ec)
+        throw Exception(_fmt("Failed to get the status of the path: \"{}\" ({})", path, ec.message()));
+
+    return rslt;
+}
+
+WFS_API FileStatus lstatus(const String& path)
+{
+    std::error_code ec;
+    FileStatus rslt = _status(path, false, ec);
+
+    if (ec)
+        throw Exception(_fmt("Failed to get the status of the path: \"{}\" ({})", path, ec.message()));
+
+    return rslt;
+}
+
+WFS_API bool isExists(const String& path)
+{
+    return status(path).exists();
+}
+
+WFS_API bool isFile(const String& path)
+{
+    return status(path).isFile();
+}
+
+WFS_API bool isDirectory(const String& path)
+{
+    return status(path).isDirectory();
+}
+
+WFS_API bool isSymlink(const String& path)
+{
+    return lstatus(path).isSymlink();
+}
+
+WFS_API bool isEmpty(const String& path)
+{
+    return fs::is_empty(path);
+}
+
+WFS_API bool isRelative(const String& path)
+{
+    return PathView(path).isRelative();
+}
+
+WFS_API bool isAbsolute(const String& path)
+{
+    return PathView(path).isAbsolute();
+}
+
+struct _CurrentPathCache
+{
+    std::mutex mutex;
+    String path;
+    bool isValid = false;
+};
+
+WFS_API _CurrentPathCache& _currentPathCache()
+{
+    static _CurrentPathCache cache;
+    return cache;
+}
+
+WFS_API String cachedCurrentPath()
+{
+    auto& cache = _currentPathCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    if (!cache.isValid)
+    {
+        cache.path = currentPath();
+        cache.isValid = true;
+    }
+
+    return cache.path;
+}
+
+WFS_API void refreshCurrentPath()
+{
+    String path = currentPath();
+
+    auto& cache = _currentPathCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.path = std::move(path);
+    cache.isValid = true;
+}
+
+/// @brief Make the path absolute by the current path into the buffer.
+inline void _absoluteTo(String& buffer, PathView path, PathView current)
+{
+    buffer.clear();
+
+    if (path.isAbsolute())
+    {
+        _append(buffer, path);
+        return;
+    }
+
+    size_t rootName = path.rootNameSize();
+    if (rootName != 0)
+    {
+        // The path relative to the current directory of other drive can't be resolved lexically.
+        if (_compareName(path.substr(0, rootName), current.substr(0, current.rootNameSize())) != 0)
+        {
+            buffer = fs::absolute(path.str()).string();
+            return;
+        }
+
+        path = path.substr(rootName);
+    }
+
+    // The path has the root directory but not the root name, e.g. "/path" in windows.
+    if (!path.empty() && _isSeparator(path.front()))
+    {
+        _append(buffer, current.substr(0, current.rootNameSize()));
+        _append(buffer, path);
+        return;
+    }
+
+    buffer.reserve(current.size() + path.size() + 1);
+    _append(buffer, current);
+
+    if (!path.empty())
+    {
+        if (!buffer.empty() && !_isSeparator(buffer.back()))
+            buffer.push_back(PREFERRED_PATH_SEPARATOR);
+        _append(buffer, path);
+    }
+}
+
+/// @brief Get the relative path of the absolute normalized path from the base into the buffer.
+/// @param baseNames The names of the absolute normalized base path.
+inline void _relativeTo(String& buffer, PathView path, PathView baseRoot, const Vec<PathView>& baseNames)
+{
+    buffer.clear();
+
+    if (_compareName(_rootKey(path), baseRoot) != 0)
+        return;
+
+    size_t matched = 0;
+    auto it = path.begin();
+    for (; it != path.end() && matched < baseNames.size() && *it == baseNames[matched]; ++it)
+        ++matched;
+
+    size_t ups = baseNames.size() - matched;
+    if (ups == 0 && it == path.end())
+    {
+        buffer.push_back('.');
+        return;
+    }
+
+    for (size_t i = 0; i < ups; ++i)
+    {
+        if (!buffer.empty())
+            buffer.push_back(PREFERRED_PATH_SEPARATOR);
+        buffer.append("..", 2);
+    }
+
+    for (; it != path.end(); ++it)
+    {
+        if (!buffer.empty())
+            buffer.push_back(PREFERRED_PATH_SEPARATOR);
+        _append(buffer, *it);
+    }
+
+    // Keep the trailing separator after the names.
+    if (path.size() > path.rootSize() && _isSeparator(path.back()))
+        buffer.push_back(PREFERRED_PATH_SEPARATOR);
+}
+
+WFS_API Strings relatives(const Strings& paths, const String& base)
+{
+    String current = cachedCurrentPath();
+
+    String _base;
+    _absoluteTo(_base, base, current);
+    normalizeTo(_base, _base);
+
+    Vec<PathView> baseNames(PathView(_base).begin(), PathView(_base).end());
+    PathView baseRoot = _rootKey(_base);
+
+    Strings rslt(paths.size());
+    String buffer;
+
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        _absoluteTo(buffer, paths[i], current);
+        normalizeTo(buffer, buffer);
+        _relativeTo(rslt[i], buffer, baseRoot, baseNames);
+    }
+
+    return rslt;
+}
+
+WFS_API String relative(const String& path, const String& base)
+{
+    String current = cachedCurrentPath();
+
+    String _path;
+    String _base;
+    _absoluteTo(_path, path, current);
+    _absoluteTo(_base, base, current);
+    normalizeTo(_path, _path);
+    normalizeTo(_base, _base);
+
+    Vec<PathView> baseNames(PathView(_base).begin(), PathView(_base).end());
+
+    String rslt;
+    _relativeTo(rslt, _path, _rootKey(_base), baseNames);
+    return rslt;
+}
+
+WFS_API String relative(const String& path)
+{
+    return relative(path, cachedCurrentPath());
+}
+
+WFS_API String absolute(const String& path)
+{
+    String rslt;
+    _absoluteTo(rslt, path, cachedCurrentPath());
+    return rslt;
+}
+
+WFS_API Strings absolutes(const Strings& paths, Executor* executor)
+{
+    // The string operations are cheap, so the paths are chunked to amortize the tasks.
+    constexpr size_t chunkSize = 4096;
+
+    String current = cachedCurrentPath();
+    Strings rslt(paths.size());
+
+    parallelFor((paths.size() + chunkSize - 1) / chunkSize, [&](size_t chunk)
+    {
+        size_t end = std::min(paths.size(), (chunk + 1) * chunkSize);
+        for (size_t i = chunk * chunkSize; i < end; ++i)
+            _absoluteTo(rslt[i], paths[i], current);
+    }, executor);
+
+    return rslt;
+}
+
+WFS_API bool isSubPath(const String& path, const String& base)
+{
+    String _path = absolute(path);
+    String _base = absolute(base);
+    normalizeTo(_path, _path);
+    normalizeTo(_base, _base);
+
+    if (_base.empty() || _path.size() <= _base.size() || _path.compare(0, _base.size(), _base) != 0)
+        return false;
+
+    // Match by names, e.g. the "C:/path/toto" is not a sub path of the "C:/path/to".
+    return _isSeparator(_base.back()) || _isSeparator(_path[_base.size()]);
+}
+
+WFS_API bool isEqualPath(const String& path1, const String& path2)
+{
+    String _path1 = absolute(path1);
+    String _path2 = absolute(path2);
+    normalizeTo(_path1, _path1);
+    normalizeTo(_path2, _path2);
+
+    return _path1 == _path2;
+}
+
+WFS_API bool isSameFileSystemEntity(const String& path1, const String& path2)
+{
+    return fs::equivalent(path1, path2);
+}
+
+WFS_API size_t sizes(const String& path)
+{
+    FileStatus stat = status(path);
+
+    if (stat.isFile())
+    {
+        return stat.size;
+    }
+    else if (stat.isDirectory())
+    {
+        size_t rslt = 0;
+        for (const auto& var : fs::recursive_directory_iterator(path))
+            rslt += (var.is_regular_file() ? var.file_size() : 0);
+
+        return rslt;
+    }
+    else
+    {
+        throw Exception(_fmt("The specified path not exists. \"{}\"", path));
+    }
+}
+
+WFS_API bool createDirectory(const String& path)
+{
+    return fs::create_directory(path);
+}
+
+WFS_API bool createDirectorys(const String& path)
+{
+    return fs::create_directories(path);
+}
+
+WFS_API bool deleteFile(const String& path)
+{
+    return fs::remove(path);
+}
+
+WFS_API size_t deletes(const String& path)
+{
+    return fs::remove_all(path);
+}
+
+WFS_API void copyFile(const String& src, const String& dst, bool isOverwrite)
+{
+    auto copyOptions = isOverwrite ? fs::copy_options::overwrite_existing : fs::copy_options::skip_existing;
+    fs::copy_file(src, dst, copyOptions);
+}
+
+WFS_API void copys(const String& src, const String& dst, bool isOverwrite)
+{
+    auto copyOptions = isOverwrite ? fs::copy_options::overwrite_existing : fs::copy_options::skip_existing;
+    copyOptions |= fs::copy_options::recursive;
+    fs::copy(src, dst, copyOptions);
+}
+
+WFS_API void copySymlink(const String& src, const String& dst)
+{
+    fs::copy_symlink(src, dst);
+}
+
+WFS_API void moves(const String& src, const String& dst)
+{
+    fs::rename(src, dst);
+}
+
+WFS_API void reFilename(const String& path, const String& newFilename)
+{
+    auto dst = pathcat(parentPath(path), newFilename + extension(path));
+    moves(path, dst);
+}
+
+WFS_API void reFilenameEx(const String& path, const String& newFilenameEx)
+{
+    auto dst = pathcat(parentPath(path), newFilenameEx);
+    moves(path, dst);
+}
+
+WFS_API void reExtension(const String& path, const String& newExtension)
+{
+    auto dst = pathcat(parentPath(path), filename(path) + newExtension);
+    moves(path, dst);
+}
+
+WFS_API void createSymlink(const String& src, const String& dst)
+{
+    if (isFile(src))
+        fs::create_symlink(src, dst);
+    else if (isDirectory(src))
+        fs::create_directory_symlink(src, dst);
+    else
+        throw Exception(_fmt("The specified path not exists. \"{}\"", src));
+}
+
+WFS_API String symlinkTarget(const String& path)
+{
+    return fs::read_symlink(path).string();
+}
+
+WFS_API void createHardlink(const String& src, const String& dst)
+{
+    fs::create_hard_link(src, dst);
+}
+
+WFS_API size_t hardlinkCount(const String& path)
+{
+    FileStatus stat = status(path);
+
+    if (!stat.exists())
+        throw Exception(_fmt("The specified path not exists. \"{}\"", path));
+
+    return stat.nlink;
+}
+
+WFS_API String tempDirectory()
+{
+    return fs::temp_directory_path().string();
+}
+
+WFS_API std::pair<Strings, Strings>
+getAlls(const String& path, bool isRecursive, bool (*filter)(const String&))
+{
+    if (!isDirectory(path))
+        throw Exception(_fmt("The specified path is not directory or not exists. \"{}\"", path));
+
+    Strings files;
+    Strings dirs;
+
+    if (isRecursive)
+    {
+        for (const auto& var : fs::recursive_directory_iterator(path))
+        {
+            String _path = var.path().string();
+
+            if (var.is_regular_file() && (!filter || filter(_path)))
+                files.push_back(_path);
+
+            if (var.is_directory() && (!filter || filter(_path)))
+                dirs.push_back(_path);
+        }
+    }
+    else
+    {
+        for (const auto& var : fs::directory_iterator(path))
+        {
+            String _path = var.path().string();
+
+            if (var.is_regular_file() && (!filter || filter(_path)))
+                files.push_back(_path);
+
+            if (var.is_directory() && (!filter || filter(_path)))
+                dirs.push_back(_path);
+        }
+    }
+
+    return { files, dirs };
+}
+
+WFS_API Strings getAllFiles(const String& path, bool isRecursive, bool (*filter)(const String&))
+{
+    if (!isDirectory(path))
+        throw Exception(_fmt("The specified path is not directory or not exists. \"{}\"", path));
+
+    Strings files;
+
+    if (isRecursive)
+    {
+        for (const auto& var : fs::recursive_directory_iterator(path))
+        {
+            String _path = var.path().string();
+            if (var.is_regular_file() && (!filter || filter(_path)))
+                files.push_back(_path);
+        }
+    }
+    else
+    {
+        for (const auto& var : fs::directory_iterator(path))
+        {
+            String _path = var.path().string();
+            if (var.is_regular_file() && (!filter || filter(_path)))
+                files.push_back(_path);
+        }
+    }
+
+    return files;
+}
+
+WFS_API Strings getAllDirectorys(const String& path, bool isRecursive, bool (*filter)(const String&))
+{
+    if (!isDirectory(path))
+        throw Exception(_fmt("The specified path is not directory or not exists. \"{}\"", path));
+
+    Strings dirs;
+
+    if (isRecursive)
+    {
+        for (const auto& var : fs::recursive_directory_iterator(path))
+        {
+            String _path = var.path().string();
+            if (var.is_directory() && (!filter || filter(_path)))
+                dirs.push_back(_path);
+        }
+    }
+    else
+    {
+        for (const auto& var : fs::directory_iterator(path))
+        {
+            String _path = var.path().string();
+            if (var.is_directory() && (!filter || filter(_path)))
+                dirs.push_back(_path);
+        }
+    }
+
+    return dirs;
+}
+
+#endif // !WFS_FWD
+
+} // namespace wfs
+
+// Declaration of non-throwing utility functions with filesystem.
+// The errors are reported by the error code (cleared on success) instead of the exceptions,
+// and no exception is thrown internally (except the std::bad_alloc).
+namespace wfs
+{
+
+#ifndef WFS_IMPL
+
+WFS_API String currentPath(std::error_code& ec);
+
+WFS_API bool isExists(const String& path, std::error_code& ec);
+
+WFS_API bool isFile(const String& path, std::error_code& ec);
+
+WFS_API bool isDirectory(const String& path, std::error_code& ec);
+
+WFS_API bool isSymlink(const String& path, std::error_code& ec);
+
+WFS_API bool isEmpty(const String& path, std::error_code& ec);
+
+WFS_API bool isSameFileSystemEntity(const String& path1, const String& path2, std::error_code& ec);
+
+/// @note If the path is not exists, the ec is set to the std::errc::no_such_file_or_directory.
+/// @note The directory failed to open or read while walking is skipped (the ec is set to its error),
+/// and the size of the others is returned.
+WFS_API size_t sizes(const String& path, std::error_code& ec);
+
+WFS_API bool createDirectory(const String& path, std::error_code& ec);
+
+WFS_API bool createDirectorys(const String& path, std::error_code& ec);
+
+WFS_API bool deleteFile(const String& path, std::error_code& ec);
+
+/// @return The count of the file deleted, 0 if an error occurs.
+WFS_API size_t deletes(const String& path, std::error_code& ec);
+
+WFS_API void copyFile(const String& src, const String& dst, bool isOverwrite, std::error_code& ec);
+
+WFS_API void copys(const String& src, const String& dst, bool isOverwrite, std::error_code& ec);
+
+WFS_API void copySymlink(const String& src, const String& dst, std::error_code& ec);
+
+WFS_API void moves(const String& src, const String& dst, std::error_code& ec);
+
+WFS_API void reFilename(const String& path, const String& newFilename, std::error_code& ec);
+
+WFS_API void reFilenameEx(const String& path, const String& newFilenameEx, std::error_code& ec);
+
+WFS_API void reExtension(const String& path, const String& newExtension, std::error_code& ec);
+
+/// @note If the src is not exists, the ec is set to the std::errc::no_such_file_or_directory.
+WFS_API void createSymlink(const String& src, const String& dst, std::error_code& ec);
+
+WFS_API String symlinkTarget(const String& path, std::error_code& ec);
+
+WFS_API void createHardlink(const String& src, const String& dst, std::error_code& ec);
+
+/// @return The count of the hardlinks, 0 if an error occurs.
+WFS_API size_t hardlinkCount(const String& path, std::error_code& ec);
+
+WFS_API String tempDirectory(std::error_code& ec);
+
+/// @note If the path is not a directory, the ec is set to the std::errc::not_a_directory.
+/// @note The directory failed to open or read while walking is skipped (the ec is set to its error),
+/// and the entries of the others are returned.
+WFS_API std::pair<Strings, Strings>
+getAlls(const String& path, bool isRecursive, bool (*filter)(const String&), std::error_code& ec);
+
+WFS_API Strings getAllFiles(const String& path, bool isRecursive, bool (*filter)(const String&), std::error_code& ec);
+
+WFS_API Strings getAllDirectorys(const String& path, bool isRecursive, bool (*filter)(const String&),
+                                 std::error_code& ec);
+
+#endif // !WFS_IMPL
+
+} // namespace wfs
+
+// Implementation of non-throwing utility functions with filesystem.
+namespace wfs
+{
+
+#ifndef WFS_FWD
+
+WFS_API String currentPath(std::error_code& ec)
+{
+    return fs::current_path(ec).string();
+}
+
+WFS_API bool isExists(const String& path, std::error_code& ec)
+{
+    return status(path, ec).exists();
+}
+
+WFS_API bool isFile(const String& path, std::error_code& ec)
+{
+    return status(path, ec).isFile();
+}
+
+WFS_API bool isDirectory(const String& path, std::error_code& ec)
+{
+    return status(path, ec).isDirectory();
+}
+
+WFS_API bool isSymlink(const String& path, std::error_code& ec)
+{
+    return lstatus(path, ec).isSymlink();
+}
+
+WFS_API bool isEmpty(const String& path, std::error_code& ec)
+{
+    return fs::is_empty(path, ec);
+}
+
+WFS_API bool isSameFileSystemEntity(const String& path1, const String& path2, std::error_code& ec)
+{
+    return fs::equivalent(path1, path2, ec);
+}
+
+/// @brief Walk the entries depth-first (the directory before its entries, the symlinks of the directorys are
+/// not followed) by a stack of the directory iterators, so the directory failed to open or read (e.g. EACCES)
+/// is reported to the onError and skipped, instead of ending the whole walking
+/// (the recursive_directory_iterator can't be continued after an error).
+/// @param func The callback of each entry, return false to stop the walking.
+/// @return If the walking is not stopped by the func.
+template <typename Func, typename ErrorFunc>
+bool _walkDirectory(const String& path, bool isRecursive, Func& func, ErrorFunc& onError)
+{
+    std::error_code ec;
+    Vec<fs::directory_iterator> stack;
+
+    stack.emplace_back(fs::path(path), ec);
+    if (ec)
+    {
+        onError(ec);
+        return true;
+    }
+
+    while (!stack.empty())
+    {
+        fs::directory_iterator& it = stack.back();
+        if (it == fs::directory_iterator())
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        if (!func(*it))
+            return false;
+
+        fs::path subDir;
+        if (isRecursive && it->is_directory(ec) && !it->is_symlink(ec))
+            subDir = it->path();
+
+        it.increment(ec);
+        if (ec)
+        {
+            // The rest of the directory failed to read is skipped.
+            onError(ec);
+            stack.pop_back();
+        }
+
+        if (!subDir.empty())
+        {
+            fs::directory_iterator subIt(subDir, ec);
+            if (ec)
+                onError(ec);
+            else
+                stack.push_back(std::move(subIt));
+        }
+    }
+
+    return true;
+}
+
+/// @brief Walk the directory without exceptions, the callback is called with each entry.
+/// The directory failed to open or read is skipped, and the first error is kept in the ec.
+/// @return If the walking is completed without errors.
+template <typename Func>
+bool _walk(const String& path, bool isRecursive, std::error_code& ec, Func func)
+{
+    ec.clear();
+
+    auto onEntry = [&](const fs::directory_entry& entry) -> bool
+    {
+        func(entry);
+        return true;
+    };
+    auto onError = [&](const std::error_code& _ec)
+    {
+        if (!ec)
+            ec = _ec;
+    };
+
+    _walkDirectory(path, isRecursive, onEntry, onError);
+    return !ec;
+}
+
+WFS_API size_t sizes(const String& path, std::error_code& ec)
+{
+    FileStatus stat = status(path, ec);
+    if (ec)
+        return 0;
+
+    if (stat.isFile())
+        return stat.size;
+
+    if (!stat.isDirectory())
+    {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return 0;
+    }
+
+    size_t rslt = 0;
+    _walk(path, true, ec, [&](const fs::directory_entry& entry)
+    {
+        std::error_code _ec;
+        if (entry.is_regular_file(_ec))
+        {
+            auto size = entry.file_size(_ec);
+            rslt += _ec ? 0 : static_cast<size_t>(size);
+        }
+    });
+
+    return rslt;
+}
+
+WFS_API bool createDirectory(const String& path, std::error_code& ec)
+{
+    return fs::create_directory(path, ec);
+}
+
+WFS_API bool createDirectorys(const String& path, std::error_code& ec)
+{
+    return fs::create_directories(path, ec);
+}
+
+WFS_API bool deleteFile(const String& path, std::error_code& ec)
+{
+    return fs::remove(path, ec);
+}
+
+WFS_API size_t deletes(const String& path, std::error_code& ec)
+{
+    auto cnt = fs::remove_all(path, ec);
+    return ec ? 0 : static_cast<size_t>(cnt);
+}
+
+WFS_API void copyFile(const String& src, const String& dst, bool isOverwrite, std::error_code& ec)
+{
+    auto copyOptions = isOverwrite ? fs::copy_options::overwrite_existing : fs::copy_options::skip_existing;
+    fs::copy_file(src, dst, copyOptions, ec);
+}
+
+WFS_API void copys(const String& src, const String& dst, bool isOverwrite, std::error_code& ec)
+{
+    auto copyOptions = isOverwrite ? fs::copy_options::overwrite_existing : fs::copy_options::skip_existing;
+    copyOptions |= fs::copy_options::recursive;
+    fs::copy(src, dst, copyOptions, ec);
+}
+
+WFS_API void copySymlink(const String& src, const String& dst, std::error_code& ec)
+{
+    fs::copy_symlink(src, dst, ec);
+}
+
+WFS_API void moves(const String& src, const String& dst, std::error_code& ec)
+{
+    fs::rename(src, dst, ec);
+}
+
+WFS_API void reFilename(const String& path, const String& newFilename, std::error_code& ec)
+{
+    auto dst = pathcat(parentPath(path), newFilename + extension(path));
+    moves(path, dst, ec);
+}
+
+WFS_API void reFilenameEx(const String& path, const String& newFilenameEx, std::error_code& ec)
+{
+    auto dst = pathcat(parentPath(path), newFilenameEx);
+    moves(path, dst, ec);
+}
+
+WFS_API void reExtension(const String& path, const String& newExtension, std::error_code& ec)
+{
+    auto dst = pathcat(parentPath(path), filename(path) + newExtension);
+    moves(path, dst, ec);
+}
+
+WFS_API void createSymlink(const String& src, const String& dst, std::error_code& ec)
+{
+    auto status = fs::status(src, ec);
+    if (ec)
+        return;
+
+    if (fs::is_regular_file(status))
+        fs::create_symlink(src, dst, ec);
+    else if (fs::is_directory(status))
+        fs::create_directory_symlink(src, dst, ec);
+    else
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+}
+
+WFS_API String symlinkTarget(const String& path, std::error_code& ec)
+{
+    return fs::read_symlink(path, ec).string();
+}
+
+WFS_API void createHardlink(const String& src, const String& dst, std::error_code& ec)
+{
+    fs::create_hard_link(src, dst, ec);
+}
+
+WFS_API size_t hardlinkCount(const String& path, std::error_code& ec)
+{
+    FileStatus stat = status(path, ec);
+
+    if (!ec && !stat.exists())
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+
+    return stat.nlink;
+}
+
+WFS_API String tempDirectory(std::error_code& ec)
+{
+    return fs::temp_directory_path(ec).string();
+}
+
+/// @brief Get the files and directorys without exceptions, the files or dirs can be null if not needed.
+WFS_API void _getAlls(const String& path, bool isRecursive, bool (*filter)(const String&),
+                      Strings* files, Strings* dirs, std::error_code& ec)
+{
+    if (!fs::is_directory(path, ec))
+    {
+        if (!ec)
+            ec = std::make_error_code(std::errc::not_a_directory);
+        return;
+    }
+
+    _walk(path, isRecursive, ec, [&](const fs::directory_entry& entry)
+    {
+        std::error_code _ec;
+        Strings* target = nullptr;
+
+        if (files && entry.is_regular_file(_ec))
+            target = files;
+        else if (dirs && entry.is_directory(_ec))
+            target = dirs;
+
+        if (target)
+        {
+            String _path = entry.path().string();
+            if (!filter || filter(_path))
+                target->push_back(std::move(_path));
+        }
+    });
+}
+
+WFS_API std::pair<Strings, Strings>
+getAlls(const String& path, bool isRecursive, bool (*filter)(const String&), std::error_code& ec)
+{
+    std::pair<Strings, Strings> rslt;
+    _getAlls(path, isRecursive, filter, &rslt.first, &rslt.second, ec);
+    return rslt;
+}
+
+WFS_API Strings getAllFiles(const String& path, bool isRecursive, bool (*filter)(const String&), std::error_code& ec)
+{
+    Strings files;
+    _getAlls(path, isRecursive, filter, &files, nullptr, ec);
+    return files;
+}
+
+WFS_API Strings getAllDirectorys(const String& path, bool isRecursive, bool (*filter)(const String&),
+                                 std::error_code& ec)
+{
+    Strings dirs;
+    _getAlls(path, isRecursive, filter, nullptr, &dirs, ec);
+    return dirs;
+}
+
+#endif // !WFS_FWD
+
+} // namespace wfs
+
+// Declaration of the cancellable operations.
+// The operations return the partial results when cancelled, and the errors of the entries are
+// counted in the stats and skipped (no exception is thrown except the std::bad_alloc).
+// The directorys are walked in parallel by the executor (nullptr means the ioExecutor()),
+// the entries of each directory and the subdirectorys are processed concurrently.
+namespace wfs
+{
+
+#ifndef WFS_IMPL
+
+/// @return The size of the file or directory (the files summed before the cancellation).
+WFS_API size_t sizes(const String& path, const CancelToken& token, OperationStats* stats = nullptr,
+                     Executor* executor = nullptr);
+
+/// @brief Recursive delete a file or directory, the directory is deleted after its entries (deepest first).
+/// @return The count of the file and directory deleted.
+WFS_API size_t deletes(const String& path, const CancelToken& token, OperationStats* stats = nullptr,
+                       Executor* executor = nullptr);
+
+/// @brief Copy a file or directory, the file data is copied by chunks.
+/// @note The file being copied when cancelled is removed (no partial file is left),
+/// and the file overwritten is replaced only when the copy is completed.
+/// The existing file is skipped if not overwrite (not counted as an error), same as the copys().
+WFS_API void copys(const String& src, const String& dst, bool isOverwrite, const CancelToken& token,
+                   OperationStats* stats = nullptr, Executor* executor = nullptr);
+
+/// @note The order of the entries is unspecified (but a directory is before its entries),
+/// and the filter is called by one thread at a time.
+WFS_API std::pair<Strings, Strings> getAlls(const String& path, bool isRecursive, bool (*filter)(const String&),
+                                            const CancelToken& token, OperationStats* stats = nullptr,
+                                            Executor* executor = nullptr);
+
+WFS_API Strings getAllFiles(const String& path, bool isRecursive, bool (*filter)(const String&),
+                            const CancelToken& token, OperationStats* stats = nullptr, Executor* executor = nullptr);
+
+WFS_API Strings getAllDirectorys(const String& path, bool isRecursive, bool (*filter)(const String&),
+                                 const CancelToken& token, OperationStats* stats = nullptr,
+                                 Executor* executor = nullptr);
+
+/// @brief Call the func for each file (not materialized), stop if the func returns false.
+/// @note The files are walked in the caller thread (the func is called in order, not by the executor).
+/// @return The count of the files visited.
+WFS_API size_t walkFiles(const String& path, bool isRecursive, const std::function<bool(const String&)>& func);
+
+#endif // !WFS_IMPL
+
+} // namespace wfs
+
+// Implementation of the cancellable operations.
+namespace wfs
+{
+
+#ifndef WFS_FWD
+
+inline void _finishStats(OperationStats* out, OperationStats& stats, const CancelToken& token,
+                         std::chrono::steady_clock::time_point start)
+{
+    stats.isCancelled = stats.isCancelled || token.isCancelled();
+    stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    if (out)
+        *out = stats;
+}
+
+/// @brief Walk the entries, the token is checked before each entry.
+/// The directory failed to open or read is counted in the stats.errors and skipped.
+/// @return If the walking is completed (not cancelled).
+template <typename Func>
+bool _walk(const String& path, bool isRecursive, const CancelToken& token, OperationStats& stats, Func func)
+{
+    auto onEntry = [&](const fs::directory_entry& entry) -> bool
+    {
+        if (token.isCancelled())
+        {
+            stats.isCancelled = true;
+            return false;
+        }
+
+        ++stats.entries;
+        func(entry);
+        return true;
+    };
+    auto onError = [&](const std::error_code&) { ++stats.errors; };
+
+    return _walkDirectory(path, isRecursive, onEntry, onError);
+}
+
+/// @brief Copy the file by chunks, and remove the dst if cancelled or failed.
+/// The overwriting copy is written to a temporary file beside the dst and renamed over the dst when completed,
+/// so the existing dst is kept if cancelled or failed.
+/// @return If the file is copied, false if the dst is exists and not overwrite (the ec is file_exists), or cancelled,
+/// or failed.
+WFS_API bool _copyFileChunked(const String& src, const String& dst, bool isOverwrite, const CancelToken& token,
+                              OperationStats& stats, std::error_code& ec)
+{
+    ec.clear();
+
+#ifdef _WRAPPED_FILESYS_POSIX
+    int in = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(in, &st) != 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        ::close(in);
+        return false;
+    }
+
+    // The copying to the file itself would truncate it.
+    struct stat dstSt;
+    if (::stat(dst.c_str(), &dstSt) == 0 && dstSt.st_dev == st.st_dev && dstSt.st_ino == st.st_ino)
+    {
+        ec = std::make_error_code(std::errc::file_exists);
+        ::close(in);
+        return false;
+    }
+
+    String target = isOverwrite ? dst + ".XXXXXX" : dst;
+    int out = isOverwrite ? ::mkstemp(&target[0]) :
+                            ::open(dst.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 07777);
+    if (out < 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        ::close(in);
+        return false;
+    }
+
+    if (isOverwrite)
+    {
+        ::fcntl(out, F_SETFD, FD_CLOEXEC);
+        ::fchmod(out, st.st_mode & 07777);
+    }
+
+    bool isCompleted = false;
+    size_t chunkSize = bufferSize(BufferUsage::Copy, static_cast<size_t>(st.st_blksize));
+    size_t copied = 0;
+    IoBuffer buffer;
+
+    while (!token.isCancelled())
+    {
+        ssize_t len = -1;
+
+    #ifdef __linux__
+        // The copy_file_range() copies in the kernel (or by the reflink), fall back to the read/write if not supported.
+        if (buffer.empty())
+        {
+            len = ::copy_file_range(in, nullptr, out, nullptr, chunkSize, 0);
+            if (len < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP))
+                buffer = IoBuffer(chunkSize);
+        }
+    #else
+        if (buffer.empty())
+            buffer = IoBuffer(chunkSize);
+    #endif // __linux__
+
+        if (!buffer.empty())
+        {
+            len = ::read(in, buffer.data(), buffer.size());
+            for (ssize_t pos = 0; len > 0 && pos < len;)
+            {
+                ssize_t written = ::write(out, buffer.data() + pos, static_cast<size_t>(len - pos));
+                if (written < 0 && errno != EINTR)
+                {
+                    len = -1;
+                    break;
+                }
+                pos += written < 0 ? 0 : written;
+            }
+        }
+
+        if (len < 0 && errno == EINTR)
+            continue;
+
+        if (len < 0)
+        {
+            ec = std::error_code(errno, std::generic_category());
+            break;
+        }
+
+        // The copy_file_range() copies nothing from some files of the procfs, sysfs or fuse (the read() works),
+        // so the nothing copied at first is not trusted as the end.
+        if (len == 0 && buffer.empty() && copied == 0)
+        {
+            buffer = IoBuffer(chunkSize);
+            continue;
+        }
+
+        if (len == 0)
+        {
+            isCompleted = true;
+            break;
+        }
+
+        copied += static_cast<size_t>(len);
+        stats.bytes += static_cast<size_t>(len);
+    }
+
+    ::close(in);
+    if (::close(out) != 0 && isCompleted)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        isCompleted = false;
+    }
+
+    if (isCompleted && isOverwrite && ::rename(target.c_str(), dst.c_str()) != 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        isCompleted = false;
+    }
+
+    if (!isCompleted)
+        ::unlink(target.c_str());
+#else
+    if (fs::equivalent(src, dst, ec))
+    {
+        ec = std::make_error_code(std::errc::file_exists);
+        return false;
+    }
+
+    ec.clear();
+    if (!isOverwrite && fs::exists(dst, ec))
+    {
+        ec = std::make_error_code(std::errc::file_exists);
+        return false;
+    }
+    if (ec)
+        return false;
+
+    String target = isOverwrite ? _fmt("{}.{}.tmp", dst, std::hash<std::thread::id>()(std::this_thread::get_id())) : dst;
+
+    bool isCompleted = false;
+    {
+        std::ifstream ifs(src, std::ios_base::binary);
+        std::ofstream ofs(target, std::ios_base::binary | std::ios_base::trunc);
+        if (!ifs || !ofs)
+        {
+            ec = std::make_error_code(std::errc::io_error);
+            return false;
+        }
+
+        IoBuffer buffer(bufferSize(BufferUsage::Copy));
+        while (!token.isCancelled())
+        {
+            ifs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            size_t len = static_cast<size_t>(ifs.gcount());
+            if (len == 0)
+            {
+                isCompleted = !ifs.bad();
+                break;
+            }
+
+            if (!ofs.write(buffer.data(), static_cast<std::streamsize>(len)))
+                break;
+
+            stats.bytes += len;
+        }
+
+        if (!isCompleted && !token.isCancelled())
+            ec = std::make_error_code(std::errc::io_error);
+    }
+
+    if (isCompleted && isOverwrite)
+    {
+        fs::rename(target, dst, ec);
+        isCompleted = !ec;
+    }
+
+    if (!isCompleted)
+    {
+        std::error_code _ec;
+        fs::remove(target, _ec);
+    }
+#endif // _WRAPPED_FILESYS_POSIX
+
+    if (!isCompleted && !ec)
+        stats.isCancelled = true;
+
+    return isCompleted;
+}
+
+/// @brief Walk the tree in parallel by the executor, the entries of each directory are visited by the parallelFor,
+/// which is nested for the subdirectorys, so the threads of the executor are shared without the oversubscription.
+/// The token is checked before each entry, and the directory failed to open or read is counted and skipped.
+/// @note The onEntry(entry, stats) is called concurrently, and returns if walk into the entry (if a directory,
+/// the symlinks are not followed). The onLeave(dir, isCompleted, stats) is called after the entries of the directory
+/// are walked, and returns if the directory is completed. The stats passed to them are merged after the call.
+template <typename EntryFunc, typename LeaveFunc>
+class _ParallelWalker
+{
+public:
+    _ParallelWalker(const CancelToken& token, OperationStats& stats, Executor* executor, EntryFunc& onEntry,
+                    LeaveFunc& onLeave) :
+        token_(token), stats_(stats), executor_(executor != nullptr ? executor : &ioExecutor()), onEntry_(onEntry),
+        onLeave_(onLeave)
+    {}
+
+    /// @return If the directory is walked completely (not cancelled, and no error of it and its subdirectorys).
+    bool walk(const fs::path& dir)
+    {
+        OperationStats stats;
+        Vec<fs::directory_entry> entries;
+
+        std::error_code ec;
+        for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+            entries.push_back(*it);
+
+        if (ec)
+            ++stats.errors;
+
+        std::atomic<bool> isSubCompleted(true);
+        parallelFor(entries.size(), [&](size_t i)
+        {
+            if (token_.isCancelled())
+                return;
+
+            OperationStats _stats;
+            ++_stats.entries;
+
+            const fs::directory_entry& entry = entries[i];
+            bool isWalk = onEntry_(entry, _stats);
+            merge_(_stats);
+
+            std::error_code _ec;
+            if (isWalk && entry.is_directory(_ec) && !entry.is_symlink(_ec) && !walk(entry.path()))
+                isSubCompleted = false;
+        }, executor_);
+
+        bool isCompleted = onLeave_(dir, !ec && isSubCompleted && !token_.isCancelled(), stats);
+        merge_(stats);
+
+        return isCompleted;
+    }
+
+private:
+    void merge_(const OperationStats& stats)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.entries += stats.entries;
+        stats_.bytes += stats.bytes;
+        stats_.errors += stats.errors;
+        stats_.isCancelled = stats_.isCancelled || stats.isCancelled;
+    }
+
+    const CancelToken& token_;
+    OperationStats& stats_;
+    Executor* executor_;
+    EntryFunc& onEntry_;
+    LeaveFunc& onLeave_;
+    std::mutex mutex_;
+};
+
+/// @return If the walking is completed, see the _ParallelWalker.
+template <typename EntryFunc, typename LeaveFunc>
+bool _walkParallel(const String& path, const CancelToken& token, OperationStats& stats, Executor* executor,
+                   EntryFunc onEntry, LeaveFunc onLeave)
+{
+    _ParallelWalker<EntryFunc, LeaveFunc> walker(token, stats, executor, onEntry, onLeave);
+    return walker.walk(path);
+}
+
+WFS_API size_t sizes(const String& path, const CancelToken& token, OperationStats* stats, Executor* executor)
+{
+    auto start = std::chrono::steady_clock::now();
+    OperationStats _stats;
+
+    std::error_code ec;
+    FileStatus stat = status(path, ec);
+
+    if (ec || !stat.exists())
+    {
+        ++_stats.errors;
+    }
+    else if (!stat.isDirectory())
+    {
+        ++_stats.entries;
+        _stats.bytes = stat.size;
+    }
+    else
+    {
+        auto onEntry = [](const fs::directory_entry& entry, OperationStats& entryStats) -> bool
+        {
+            std::error_code _ec;
+            if (entry.is_regular_file(_ec))
+            {
+                auto size = entry.file_size(_ec);
+                entryStats.bytes += _ec ? 0 : static_cast<size_t>(size);
+            }
+
+            if (_ec)
+                ++entryStats.errors;
+
+            return true;
+        };
+        auto onLeave = [](const fs::path&, bool isCompleted, OperationStats&) { return isCompleted; };
+
+        _walkParallel(path, token, _stats, executor, onEntry, onLeave);
+    }
+
+    _finishStats(stats, _stats, token, start);
+    return _stats.bytes;
+}
+
+WFS_API size_t deletes(const String& path, const CancelToken& token, OperationStats* stats, Executor* executor)
+{
+    auto start = std::chrono::steady_clock::now();
+    OperationStats _stats;
+    std::atomic<size_t> count(0);
+
+    std::error_code ec;
+    FileStatus stat = lstatus(path, ec);
+
+    if (ec || !stat.exists())
+    {
+        ++_stats.errors;
+    }
+    else if (!stat.isDirectory())
+    {
+        ++_stats.entries;
+        if (fs::remove(path, ec))
+            count = 1;
+        else
+            ++_stats.errors;
+    }
+    else if (!token.isCancelled())
+    {
+        auto onEntry = [&](const fs::directory_entry& entry, OperationStats& entryStats) -> bool
+        {
+            std::error_code _ec;
+            if (entry.is_directory(_ec) && !entry.is_symlink(_ec))
+                return true;
+
+            if (fs::remove(entry.path(), _ec))
+                ++count;
+            else
+                ++entryStats.errors;
+
+            return false;
+        };
+
+        // The directory is deleted after all its entries are deleted (deepest first).
+        auto onLeave = [&](const fs::path& dir, bool isCompleted, OperationStats& dirStats) -> bool
+        {
+            if (!isCompleted)
+                return false;
+
+            std::error_code _ec;
+            if (!fs::remove(dir, _ec))
+            {
+                ++dirStats.errors;
+                return false;
+            }
+
+            ++count;
+            return true;
+        };
+
+        _walkParallel(path, token, _stats, executor, onEntry, onLeave);
+    }
+
+    _finishStats(stats, _stats, token, start);
+    return count;
+}
+
+WFS_API void copys(const String& src, const String& dst, bool isOverwrite, const CancelToken& token,
+                   OperationStats* stats, Executor* executor)
+{
+    auto start = std::chrono::steady_clock::now();
+    OperationStats _stats;
+
+    // The existing file skipped (not overwrite) is not an error.
+    auto isFailed = [&](const std::error_code& _ec) { return _ec && (isOverwrite || _ec != std::errc::file_exists); };
+
+    std::error_code ec;
+    FileStatus stat = status(src, ec);
+
+    if (ec || !stat.exists())
+    {
+        ++_stats.errors;
+    }
+    else if (!stat.isDirectory())
+    {
+        ++_stats.entries;
+        _copyFileChunked(src, dst, isOverwrite, token, _stats, ec);
+        _stats.errors += isFailed(ec) ? 1 : 0;
+    }
+    else if (!fs::create_directories(dst, ec) && ec)
+    {
+        ++_stats.errors;
+    }
+    else
+    {
+        fs::path _src(src);
+        fs::path _dst(dst);
+
+        // The directory is created before its entries are copied.
+        auto onEntry = [&](const fs::directory_entry& entry, OperationStats& entryStats) -> bool
+        {
+            std::error_code _ec;
+            fs::path target = _dst / entry.path().lexically_relative(_src);
+            bool isWalk = false;
+
+            if (entry.is_directory(_ec))
+            {
+                fs::create_directory(target, _ec);
+                isWalk = !_ec;
+            }
+            else if (entry.is_regular_file(_ec))
+            {
+                _copyFileChunked(entry.path().string(), target.string(), isOverwrite, token, entryStats, _ec);
+            }
+
+            entryStats.errors += isFailed(_ec) ? 1 : 0;
+            return isWalk;
+        };
+        auto onLeave = [](const fs::path&, bool isCompleted, OperationStats&) { return isCompleted; };
+
+        _walkParallel(src, token, _stats, executor, onEntry, onLeave);
+    }
+
+    _finishStats(stats, _stats, token, start);
+}
+
+/// @brief Same as the _getAlls() but cancellable.
+WFS_API void _getAlls(const String& path, bool isRecursive, bool (*filter)(const String&), Strings* files,
+                      Strings* dirs, const CancelToken& token, OperationStats* stats, Executor* executor)
+{
+    auto start = std::chrono::steady_clock::now();
+    OperationStats _stats;
+    std::mutex mutex;
+
+    auto onEntry = [&](const fs::directory_entry& entry, OperationStats&) -> bool
+    {
+        std::error_code _ec;
+        Strings* target = nullptr;
+
+        if (files && entry.is_regular_file(_ec))
+            target = files;
+        else if (dirs && entry.is_directory(_ec))
+            target = dirs;
+
+        if (target)
+        {
+            String _path = entry.path().string();
+
+            // The filter is called under the lock too, so it needn't be thread-safe.
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!filter || filter(_path))
+                target->push_back(std::move(_path));
+        }
+
+        return isRecursive;
+    };
+    auto onLeave = [](const fs::path&, bool isCompleted, OperationStats&) { return isCompleted; };
+
+    _walkParallel(path, token, _stats, executor, onEntry, onLeave);
+    _finishStats(stats, _stats, token, start);
+}
+
+WFS_API std::pair<Strings, Strings> getAlls(const String& path, bool isRecursive, bool (*filter)(const String&),
+                                            const CancelToken& token, OperationStats* stats, Executor* executor)
+{
+    std::pair<Strings, Strings> rslt;
+    _getAlls(path, isRecursive, filter, &rslt.first, &rslt.second, token, stats, executor);
+    return rslt;
+}
+
+WFS_API Strings getAllFiles(const String& path, bool isRecursive, bool (*filter)(const String&),
+                            const CancelToken& token, OperationStats* stats, Executor* executor)
+{
+    Strings files;
+    _getAlls(path, isRecursive, filter, &files, nullptr, token, stats, executor);
+    return files;
+}
+
+WFS_API Strings getAllDirectorys(const String& path, bool isRecursive, bool (*filter)(const String&),
+                                 const CancelToken& token, OperationStats* stats, Executor* executor)
+{
+    Strings dirs;
+    _getAlls(path, isRecursive, filter, nullptr, &dirs, token, stats, executor);
+    return dirs;
+}
+
+WFS_API size_t walkFiles(const String& path, bool isRecursive, const std::function<bool(const String&)>& func)
+{
+    CancelToken token;
+    OperationStats stats;
+    size_t rslt = 0;
+
+    _walk(path, isRecursive, token, stats, [&](const fs::directory_entry& entry)
+    {
+        std::error_code _ec;
+        if (entry.is_regular_file(_ec))
+        {
+            ++rslt;
+            if (!func(entry.path().string()))
+                token.cancel();
+        }
+    });
+
+    return rslt;
+}
+
+#endif // !WFS_FWD
+
+} // namespace wfs
+
+// Declaration of the bulk operations.
+namespace wfs
+{
+
+#ifndef WFS_IMPL
+
+/// @brief Create the directory trees of all the paths.
+/// The paths are merged into a trie of names, so each unique directory is created exactly once (top-down),
+/// and the independent branches are created in parallel.
+/// The paths contain the ".." are created serially by each prefix instead, so the ".." is resolved by the
+/// filesystem (through the symlinks), same as the createDirectorys(String).
+/// @return The count of the directory created (the existed directories are not counted).
+/// @param executor The executor to create the branches, nullptr means the ioExecutor().
+/// @note The relative paths are based on the cached current path, see the cachedCurrentPath().
+/// @note A failed directory stops its own subtree only, the other paths are still created,
+/// then the first failure is thrown (or set to the ec, and the count still includes the created ones).
+WFS_API size_t createDirectorys(const Strings& paths, Executor* executor = nullptr);
+
+WFS_API size_t createDirectorys(const Strings& paths, std::error_code& ec);
+
+WFS_API size_t createDirectorys(const Strings& paths, Executor* executor, std::error_code& ec);
+
+/// @brief Find the files with the same contents.
+/// The files are grouped by the size first, then by the hash of the first and last 4 KiB,
+/// and only the remaining candidates are hashed (128-bit) by the full contents, each stage runs in parallel.
+/// @param minSize The files smaller than it are ignored (the empty files are ignored by default).
+/// @return The groups of the duplicate files, sorted by the size descending.
+/// @param executor The executor to run the stages, nullptr means the ioExecutor().
+/// @param order The order to read the files of each stage, the next files are hinted by the readahead() if not
+/// the ReadOrder::Listing.
+/// @note The files failed to read and the non-regular files (include the symlinks) are ignored.
+/// @note The contents are compared by the non-cryptographic hash, not byte by byte.
+WFS_API Vec<DuplicateGroup> findDuplicates(const Strings& files, size_t minSize = 1, Executor* executor = nullptr,
+                                           ReadOrder order = ReadOrder::Listing);
+
+/// @brief Same as the findDuplicates() but cancellable, the groups verified before the cancellation are returned.
+WFS_API Vec<DuplicateGroup> findDuplicates(const Strings& files, size_t minSize, Executor* executor,
+                                           const CancelToken& token, OperationStats* stats = nullptr);
+
+WFS_API Vec<DuplicateGroup> findDuplicates(const Strings& files, size_t minSize, Executor* executor, ReadOrder order,
+                                           const CancelToken& token, OperationStats* stats = nullptr);
+
+/// @brief Replace the duplicate files by the first file of each group, the groups are processed in parallel.
+/// Each file is replaced atomically (the hardlink is created by a temporary name then renamed to the file,
+/// the reflink is performed by the FIDEDUPERANGE which verifies the contents by the kernel).
+/// Before the hardlink, the file is compared with the first file byte by byte (also in the dry run).
+/// @param isDryRun If true, just report the result without changing anything.
+/// @param executor The executor to process the groups, nullptr means the ioExecutor().
+/// @note The files which are changed since the duplicates found (see the DuplicateGroup::stats) or failed
+/// are skipped and reported.
+WFS_API DedupReport deduplicate(const Vec<DuplicateGroup>& groups, DedupMethod method = DedupMethod::Hardlink,
+                                bool isDryRun = false, Executor* executor = nullptr);
+
+/// @brief Load the contents of the files into the arena blocks.
+/// In Linux, the files are loaded by the io_uring (if available), the open, read and close of each file are linked
+/// and many files are in flight, and the data are read into the registered buffers,
+/// so the round trips of the syscalls are saved, it's fast for the many small files.
+/// Otherwise (and for the large files) the files are read in parallel by the executor.
+/// @param executor The executor to read the files not loaded by the io_uring, nullptr means the ioExecutor().
+/// @param order The order to read the files, the next files are hinted by the readahead() if not
+/// the ReadOrder::Listing (the files in flight of the io_uring are the hints already).
+/// @note The errors are reported by the LoadedFiles::errors, the contents are indexed by the given order always.
+WFS_API LoadedFiles loadFiles(const Strings& paths, Executor* executor = nullptr, ReadOrder order = ReadOrder::Listing);
+
+/// @brief Same as the loadFiles() but read the same range of each file, e.g. the headers of the many files.
+/// The range is clipped by the end of each file (empty if the offset is beyond it).
+WFS_API LoadedFiles loadFileRanges(const Strings& paths, size_t offset, size_t length, Executor* executor = nullptr,
+                                   ReadOrder order = ReadOrder::Listing);
+
+/// @brief Same as the loadFiles() but read the last bytes (at most the length) of each file, e.g. the footers.
+/// @note The io_uring is not used (the size of each file is needed before reading).
+WFS_API LoadedFiles loadFileTails(const Strings& paths, size_t length, Executor* executor = nullptr,
+                                  ReadOrder order = ReadOrder::Listing);
+
+/// @brief Read the whole files without waiting, the callback is called once with the contents and the errors
+/// (indexed by the given order) when all files are completed, in the completion thread of the io_uring (Linux)
+/// or in the executor.
+/// The files are read by the process-wide io_uring if available, so no thread is blocked by the reading,
+/// otherwise (and for the files not supported by the io_uring) the files are read by the executor.
+/// @param executor nullptr means the ioExecutor().
+WFS_API void _readFilesAsync(const Strings& paths, Executor* executor,
+                             std::function<void(Strings&, Vec<std::error_code>&)> callback);
+
+/// @brief Read the range of the file by a pread(), without reading the other parts.
+/// @return The data of the range, clipped by the end of the file (empty if the offset is beyond it).
+WFS_API String readFileRange(const String& path, size_t offset, size_t length);
+
+WFS_API String readFileRange(const String& path, size_t offset, size_t length, std::error_code& ec);
+
+/// @return The first bytes (at most the length) of the file, e.g. the magic bytes and the header.
+WFS_API String readFileHead(const String& path, size_t length);
+
+WFS_API String readFileHead(const String& path, size_t length, std::error_code& ec);
+
+/// @return The last bytes (at most the length) of the file, e.g. the footer and the tail of the log.
+WFS_API String readFileTail(const String& path, size_t length);
+
+WFS_API String readFileTail(const String& path, size_t length, std::error_code& ec);
+
+/// @brief Same as the deduplicate() but cancellable, the groups not started before the cancellation are skipped.
+/// @note The OperationStats::bytes is the bytes reclaimed.
+WFS_API DedupReport deduplicate(const Vec<DuplicateGroup>& groups, DedupMethod method, bool isDryRun,
+                                Executor* executor, const CancelToken& token, OperationStats* stats = nullptr);
+
+#endif // !WFS_IMPL
+
+} // namespace wfs
+
+// Implementation of the bulk operations.
+namespace wfs
+{
+
+#ifndef WFS_FWD
+
+/// @brief The trie of the directory names for the createDirectorys().
+struct _DirTreeCreator
+{
+    struct Node
+    {
+        size_t nameBegin;
+        Vec<size_t> children;
+    };
+
+    /// @brief Map the path of each node to the node index, and the key of the node i is the path of the node i.
+    PathMap<size_t> index;
+    Vec<Node> nodes;
+    Vec<size_t> roots;
+
+    std::atomic<size_t> created{ 0 };
+    /// @brief The failed nodes, whose subtrees are not created. Each flag is set by the creator of the node only.
+    Vec<uint8_t> isFailed;
+    std::mutex mutex;
+    std::error_code ec;
+    String failedPath;
+
+    /// @brief Add the nodes of the normalized absolute path.
+    void add(PathView path)
+    {
+        size_t size = path.size();
+        size_t rootSize = path.rootSize();
+
+        // Ignore the trailing separators.
+        while (size > rootSize && _isSeparator(path[size - 1]))
+            --size;
+
+        if (size == rootSize || index.contains(path.substr(0, size)))
+            return;
+
+        auto rslt = index.insert(path.substr(0, rootSize), nodes.size());
+        if (rslt.second)
+        {
+            nodes.push_back({ rootSize, {} });
+            isFailed.push_back(0);
+            roots.push_back(*rslt.first);
+        }
+
+        size_t parent = *rslt.first;
+        for (size_t pos = rootSize; pos < size;)
+        {
+            size_t end = _findSeparator(path.data(), pos, size);
+
+            rslt = index.insert(path.substr(0, end), nodes.size());
+            if (rslt.second)
+            {
+                nodes.push_back({ pos, {} });
+                isFailed.push_back(0);
+                nodes[parent].children.push_back(*rslt.first);
+            }
+
+            parent = *rslt.first;
+            pos = end + 1;
+        }
+    }
+
+    /// @brief Mark the node failed (its subtree is skipped), and keep the first error.
+    void fail(size_t node, const std::error_code& _ec)
+    {
+        isFailed[node] = 1;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!ec)
+        {
+            ec = _ec;
+            failedPath = index.key(node).str();
+        }
+    }
+
+    /// @brief Create the children of the node, and the node must be exists.
+    void createChildren(size_t node, bool isRecursive)
+    {
+        if (isFailed[node] || nodes[node].children.empty())
+            return;
+
+#ifdef _WRAPPED_FILESYS_POSIX
+        int fd = ::open(index.key(node).str().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            fail(node, std::error_code(errno, std::generic_category()));
+            return;
+        }
+
+        createChildrenAt(fd, node, isRecursive);
+        ::close(fd);
+#else
+        for (size_t child : nodes[node].children)
+        {
+            std::error_code _ec;
+            String path = index.key(child).str();
+
+            if (fs::create_directory(path, _ec))
+                ++created;
+            else if (!_ec && !fs::is_directory(path, _ec) && !_ec)
+                _ec = std::make_error_code(std::errc::file_exists);
+
+            if (_ec)
+            {
+                fail(child, _ec);
+                continue;
+            }
+
+            if (isRecursive)
+                createChildren(child, true);
+        }
+#endif // _WRAPPED_FILESYS_POSIX
+    }
+
+#ifdef _WRAPPED_FILESYS_POSIX
+    /// @brief Create the children of the node by the opened directory of the node.
+    void createChildrenAt(int dirfd, size_t node, bool isRecursive)
+    {
+        for (size_t child : nodes[node].children)
+        {
+            String name = index.key(child).substr(nodes[child].nameBegin).str();
+            bool isLeaf = !isRecursive || nodes[child].children.empty();
+
+            if (::mkdirat(dirfd, name.c_str(), 0777) == 0)
+            {
+                ++created;
+            }
+            else if (errno != EEXIST)
+            {
+                fail(child, std::error_code(errno, std::generic_category()));
+                continue;
+            }
+            else if (isLeaf)
+            {
+                // The existed entry must be a directory (the non-leaf is checked by the openat() below).
+                struct stat st;
+                if (::fstatat(dirfd, name.c_str(), &st, 0) != 0 || !S_ISDIR(st.st_mode))
+                {
+                    fail(child, std::make_error_code(std::errc::file_exists));
+                    continue;
+                }
+            }
+
+            if (isLeaf)
+                continue;
+
+            int fd = ::openat(dirfd, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                // The existed entry is not a directory.
+                fail(child, errno == ENOTDIR ? std::make_error_code(std::errc::file_exists)
+                                             : std::error_code(errno, std::generic_category()));
+                continue;
+            }
+
+            createChildrenAt(fd, child, true);
+            ::close(fd);
+        }
+    }
+#endif // _WRAPPED_FILESYS_POSIX
+};
+
+/// @brief Create each prefix of the path in order without the normalization, so the ".." is resolved by the
+/// filesystem, same as the createDirectorys(String).
+/// @return The count of the directory created.
+WFS_API size_t _createDirectoryPrefixes(const String& path, std::error_code& ec)
+{
+    ec.clear();
+    size_t rslt = 0;
+    size_t size = path.size();
+
+    for (size_t pos = PathView(path).rootSize(); pos < size;)
+    {
+        size_t end = _findSeparator(path.data(), pos, size);
+        if (end > pos)
+        {
+            // The existed directory is not an error, but the existed file is.
+            if (fs::create_directory(path.substr(0, end), ec))
+                ++rslt;
+            else if (ec)
+                break;
+        }
+
+        pos = end + 1;
+    }
+
+    return rslt;
+}
+
+/// @brief Create the directory trees of all the paths.
+/// @return The count of the directory created, and the first path failed to create if the ec is set.
+WFS_API size_t _createDirectorys(const Strings& paths, Executor* executor, String& failedPath, std::error_code& ec)
+{
+    _DirTreeCreator creator;
+    String current = cachedCurrentPath();
+    String buffer;
+    Strings serialPaths;
+
+    for (const auto& path : paths)
+    {
+        if (path.empty())
+            continue;
+
+        _absoluteTo(buffer, path, current);
+
+        bool isDotDot = false;
+        for (PathView name : PathView(buffer))
+            isDotDot = isDotDot || name == PathView("..");
+
+        if (isDotDot)
+        {
+            serialPaths.push_back(buffer);
+            continue;
+        }
+
+        normalizeTo(buffer, buffer);
+        creator.add(buffer);
+    }
+
+    // Create the top levels serially until there are enough independent branches.
+    Vec<size_t> frontier = creator.roots;
+    size_t minBranchCount = 4 * (executor != nullptr ? executor : &ioExecutor())->concurrency();
+
+    while (frontier.size() < minBranchCount)
+    {
+        Vec<size_t> next;
+        for (size_t node : frontier)
+        {
+            creator.createChildren(node, false);
+            for (size_t child : creator.nodes[node].children)
+            {
+                if (!creator.isFailed[child])
+                    next.push_back(child);
+            }
+        }
+
+        if (next.empty())
+            break;
+
+        frontier.swap(next);
+    }
+
+    parallelFor(frontier.size(), [&](size_t i) { creator.createChildren(frontier[i], true); },
+                executor != nullptr ? executor : &ioExecutor());
+
+    ec = creator.ec;
+    failedPath = creator.failedPath;
+    size_t rslt = creator.created;
+
+    for (const auto& path : serialPaths)
+    {
+        std::error_code _ec;
+        rslt += _createDirectoryPrefixes(path, _ec);
+
+        if (_ec && !ec)
+        {
+            ec = _ec;
+            failedPath = path;
+        }
+    }
+
+    return rslt;
+}
+
+WFS_API size_t createDirectorys(const Strings& paths, Executor* executor)
+{
+    String failedPath;
+    std::error_code ec;
+    size_t rslt = _createDirectorys(paths, executor, failedPath, ec);
+
+    if (ec)
+        throw Exception(_fmt("Failed to create the directory: \"{}\" ({})", failedPath, ec.message()));
+
+    return rslt;
+}
+
+WFS_API size_t createDirectorys(const Strings& paths, std::error_code& ec)
+{
+    String failedPath;
+    return _createDirectorys(paths, nullptr, failedPath, ec);
+}
+
+WFS_API size_t createDirectorys(const Strings& paths, Executor* executor, std::error_code& ec)
+{
+    String failedPath;
+    return _createDirectorys(paths, executor, failedPath, ec);
+}
+
+/// @brief The bytes read from each end of the file for the quick comparison of the findDuplicates().
+constexpr size_t _DUPLICATE_PROBE_SIZE = 4096;
+
+#ifdef _WRAPPED_FILESYS_POSIX
+/// @brief Read the count bytes at the offset, until the end of the file.
+/// @return The count of the bytes read, -1 if failed.
+inline ssize_t _preadAll(int fd, char* buffer, size_t count, size_t offset)
+{
+    size_t rslt = 0;
+
+    while (rslt < count)
+    {
+        ssize_t len = ::pread(fd, buffer + rslt, count - rslt, static_cast<off_t>(offset + rslt));
+        if (len < 0 && errno == EINTR)
+            continue;
+        if (len < 0)
+            return -1;
+        if (len == 0)
+            break;
+        rslt += static_cast<size_t>(len);
+    }
+
+    return static_cast<ssize_t>(rslt);
+}
+#endif // _WRAPPED_FILESYS_POSIX
+
+/// @return The hash of the first and last bytes (at most _DUPLICATE_PROBE_SIZE each) of the file.
+WFS_API uint64_t _hashFileEnds(const String& path, size_t size, std::error_code& ec)
+{
+    ec.clear();
+
+    char buffer[2 * _DUPLICATE_PROBE_SIZE];
+    size_t head = std::min(size, _DUPLICATE_PROBE_SIZE);
+    size_t tail = std::min(size - head, _DUPLICATE_PROBE_SIZE);
+
+#ifdef _WRAPPED_FILESYS_POSIX
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        return 0;
+    }
+
+    ssize_t headLen = _preadAll(fd, buffer, head, 0);
+    ssize_t tailLen = headLen < 0 ? 0 : _preadAll(fd, buffer + head, tail, size - tail);
+
+    if (headLen < 0 || tailLen < 0)
+        ec = std::error_code(errno, std::generic_category());
+    else if (static_cast<size_t>(headLen) != head || static_cast<size_t>(tailLen) != tail)
+        ec = std::make_error_code(std::errc::io_error);    // The file is truncated.
+
+    ::close(fd);
+#else
+    std::ifstream ifs(path, std::ios_base::binary);
+    ifs.read(buffer, static_cast<std::streamsize>(head));
+    ifs.seekg(static_cast<std::streamoff>(size - tail));
+    ifs.read(buffer + head, static_cast<std::streamsize>(tail));
+
+    if (!ifs)
+        ec = std::make_error_code(std::errc::io_error);
+#endif // _WRAPPED_FILESYS_POSIX
+
+    return ec ? 0 : hashBytes(buffer, head + tail, size);
+}
+
+/// @return The 128-bit hash (two hashes with different seeds) of the full contents of the file.
+WFS_API std::pair<uint64_t, uint64_t> _hashFileContents(const String& path, std::error_code& ec)
+{
+    constexpr size_t chunkSize = 1 << 20;
+    std::pair<uint64_t, uint64_t> rslt(0, 0x9E3779B97F4A7C15ull);
+
+    ec.clear();
+
+#ifdef _WRAPPED_FILESYS_POSIX
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        return rslt;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        ::close(fd);
+        return rslt;
+    }
+
+    // Read by the pread (not the mmap), so a file truncated meanwhile is an error rather than a SIGBUS.
+    size_t size = static_cast<size_t>(st.st_size);
+    IoBuffer buffer(std::min(chunkSize, size + 1));
+
+    // Hash both by the chunk, so the chunk is read once, and read one more byte to detect the growth.
+    for (size_t pos = 0; pos <= size;)
+    {
+        size_t len = std::min(buffer.size(), size - pos + 1);
+        ssize_t readLen = _preadAll(fd, buffer.data(), len, pos);
+        if (readLen < 0)
+        {
+            ec = std::error_code(errno, std::generic_category());
+            break;
+        }
+
+        size_t expected = std::min(len, size - pos);
+        if (static_cast<size_t>(readLen) != expected)
+        {
+            ec = std::make_error_code(std::errc::io_error);    // The file is truncated or grown.
+            break;
+        }
+
+        if (expected == 0)
+            break;
+
+        rslt.first = hashBytes(buffer.data(), expected, rslt.first);
+        rslt.second = hashBytes(buffer.data(), expected, rslt.second);
+        pos += expected;
+    }
+
+    ::close(fd);
+#else
+    std::ifstream ifs(path, std::ios_base::binary);
+    if (!ifs)
+    {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return rslt;
+    }
+
+    Vec<char> buffer(chunkSize);
+    while (ifs)
+    {
+        ifs.read(buffer.data(), static_cast<std::streamsize>(chunkSize));
+        size_t len = static_cast<size_t>(ifs.gcount());
+        if (len == 0)
+            break;
+
+        rslt.first = hashBytes(buffer.data(), len, rslt.first);
+        rslt.second = hashBytes(buffer.data(), len, rslt.second);
+    }
+
+    if (ifs.bad())
+        ec = std::make_error_code(std::errc::io_error);
+#endif // _WRAPPED_FILESYS_POSIX
+
+    return rslt;
+}
+
+/// @return If the files are the same size and the same contents byte by byte, false if failed to read (the ec is set).
+WFS_API bool _isSameFileContents(const String& path1, const String& path2, size_t size, std::error_code& ec)
+{
+    constexpr size_t chunkSize = 1 << 20;
+    bool rslt = true;
+
+    ec.clear();
+
+#ifdef _WRAPPED_FILESYS_POSIX
+    int fd1 = ::open(path1.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd1 < 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        return false;
+    }
+
+    int fd2 = ::open(path2.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd2 < 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        ::close(fd1);
+        return false;
+    }
+
+    IoBuffer buffer(2 * chunkSize);
+    char* data1 = buffer.data();
+    char* data2 = buffer.data() + chunkSize;
+
+    // Read one more byte after the size to detect the growth of either file.
+    for (size_t pos = 0; pos <= size && rslt; pos += chunkSize)
+    {
+        size_t len = std::min(chunkSize, size - pos + 1);
+        ssize_t len1 = _preadAll(fd1, data1, len, pos);
+        ssize_t len2 = len1 < 0 ? 0 : _preadAll(fd2, data2, len, pos);
+
+        if (len1 < 0 || len2 < 0)
+        {
+            ec = std::error_code(errno, std::generic_category());
+            rslt = false;
+        }
+        else
+        {
+            size_t expected = std::min(len, size - pos);
+            rslt = static_cast<size_t>(len1) == expected && static_cast<size_t>(len2) == expected &&
+                   std::memcmp(data1, data2, expected) == 0;
+        }
+    }
+
+    ::close(fd2);
+    ::close(fd1);
+#else
+    std::ifstream ifs1(path1, std::ios_base::binary);
+    std::ifstream ifs2(path2, std::ios_base::binary);
+    if (!ifs1 || !ifs2)
+    {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return false;
+    }
+
+    Vec<char> buffer1(chunkSize), buffer2(chunkSize);
+    size_t total = 0;
+    while (rslt)
+    {
+        ifs1.read(buffer1.data(), static_cast<std::streamsize>(chunkSize));
+        ifs2.read(buffer2.data(), static_cast<std::streamsize>(chunkSize));
+        size_t len1 = static_cast<size_t>(ifs1.gcount());
+        size_t len2 = static_cast<size_t>(ifs2.gcount());
+
+        rslt = len1 == len2 && std::memcmp(buffer1.data(), buffer2.data(), len1) == 0;
+        total += len1;
+        if (len1 == 0)
+            break;
+    }
+
+    if (ifs1.bad() || ifs2.bad())
+    {
+        ec = std::make_error_code(std::errc::io_error);
+        rslt = false;
+    }
+
+    rslt = rslt && total == size;
+#endif // _WRAPPED_FILESYS_POSIX
+
+    return rslt;
+}
+
+/// @brief Keep the items which have the same key with others, the items are sorted by the key.
+template <typename Key>
+void _keepDuplicated(Vec<size_t>& items, Key key)
+{
+    std::sort(items.begin(), items.end(), [&](size_t a, size_t b) { return key(a) < key(b); });
+
+    Vec<size_t> rslt;
+    for (size_t i = 0, j = 0; i < items.size(); i = j)
+    {
+        for (j = i + 1; j < items.size() && key(items[j]) == key(items[i]); ++j) {}
+
+        if (j - i >= 2)
+            rslt.insert(rslt.end(), items.begin() + static_cast<ptrdiff_t>(i), items.begin() + static_cast<ptrdiff_t>(j));
+    }
+
+    items.swap(rslt);
+}
+
+/// @brief The count of the next files hinted by the readahead() in the batch reads.
+constexpr size_t _READAHEAD_COUNT = 8;
+
+/// @brief The location of the file data on the storage, the batch reads are sorted by it.
+struct _ReadLocation
+{
+    uint64_t device;
+    /// @brief The physical offset of the first extent, the max if unknown (or not the ReadOrder::Physical).
+    uint64_t physical;
+    uint64_t inode;
+    size_t size;
+
+    bool operator<(const _ReadLocation& other) const
+    {
+        return std::tie(device, physical, inode) < std::tie(other.device, other.physical, other.inode);
+    }
+};
+
+/// @return The location of the file by the order, the files failed to stat are located at the end.
+WFS_API _ReadLocation _readLocation(const String& path, ReadOrder order)
+{
+    _ReadLocation rslt = { UINT64_MAX, UINT64_MAX, UINT64_MAX, 0 };
+
+    std::error_code ec;
+    FileStatus stat = status(path, ec);
+    if (ec)
+        return rslt;
+
+    rslt.device = stat.device;
+    rslt.inode = stat.inode;
+    rslt.size = stat.size;
+
+#if defined(__linux__) && defined(FS_IOC_FIEMAP)
+    if (order == ReadOrder::Physical && stat.isFile() && stat.size > 0)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            // Just the first extent is queried.
+            alignas(struct fiemap) char buffer[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = {};
+            struct fiemap* map = reinterpret_cast<struct fiemap*>(buffer);
+            map->fm_length = FIEMAP_MAX_OFFSET;
+            map->fm_extent_count = 1;
+
+            const uint32_t unknown = FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DATA_INLINE;
+            if (::ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0 &&
+                (map->fm_extents[0].fe_flags & unknown) == 0)
+            {
+                rslt.physical = map->fm_extents[0].fe_physical;
+            }
+
+            ::close(fd);
+        }
+    }
+#else
+    (void)order;
+#endif // __linux__ && FS_IOC_FIEMAP
+
+    return rslt;
+}
+
+/// @brief Sort the items by the locations of the files (located in parallel), the ties keep the given order.
+/// @param pathOf Get the path of the item.
+/// @return The locations of the sorted items.
+template <typename PathOf>
+Vec<_ReadLocation> _sortByReadOrder(Vec<size_t>& items, ReadOrder order, PathOf pathOf, Executor* executor)
+{
+    Vec<_ReadLocation> locations(items.size());
+    parallelFor(items.size(), [&](size_t i) { locations[i] = _readLocation(pathOf(items[i]), order); }, executor);
+
+    Vec<size_t> indices(items.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = i;
+
+    std::stable_sort(indices.begin(), indices.end(), [&](size_t a, size_t b) { return locations[a] < locations[b]; });
+
+    Vec<size_t> _items;
+    Vec<_ReadLocation> _locations;
+    _items.reserve(items.size());
+    _locations.reserve(items.size());
+
+    for (size_t i : indices)
+    {
+        _items.push_back(items[i]);
+        _locations.push_back(locations[i]);
+    }
+
+    items.swap(_items);
+    return _locations;
+}
+
+/// @brief Hint the kernel to read the range of the file into the page cache asynchronously (Linux only).
+WFS_API void _readahead(const String& path, size_t offset, size_t count)
+{
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    ::readahead(fd, static_cast<off64_t>(offset), count);
+    ::close(fd);
+#else
+    (void)path;
+    (void)offset;
+    (void)count;
+#endif // __linux__
+}
+
+WFS_API Vec<DuplicateGroup> findDuplicates(const Strings& files, size_t minSize, Executor* executor, ReadOrder order,
+                                           const CancelToken& token, OperationStats* opStats)
+{
+    if (executor == nullptr)
+        executor = &ioExecutor();
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> entries(0);
+    std::atomic<size_t> bytes(0);
+
+    Vec<FileStatus> stats(files.size());
+    parallelFor(files.size(), [&](size_t i)
+    {
+        if (token.isCancelled())
+            return;
+
+        std::error_code ec;
+        stats[i] = lstatus(files[i], ec);
+        ++entries;
+    }, executor);
+
+    // Merge the hardlinks, each file is read once.
+    struct Inode
+    {
+        size_t size;
+        uint64_t device;
+        uint64_t inode;
+        Vec<size_t> paths;
+        uint64_t endsHash;
+        std::pair<uint64_t, uint64_t> hash;
+        bool isFailed;
+    };
+
+    Vec<size_t> candidates;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        if (stats[i].isFile() && stats[i].size >= minSize)
+            candidates.push_back(i);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b)
+    {
+        return std::make_tuple(stats[a].size, stats[a].device, stats[a].inode, a) <
+               std::make_tuple(stats[b].size, stats[b].device, stats[b].inode, b);
+    });
+
+    Vec<Inode> inodes;
+    for (size_t i : candidates)
+    {
+        const FileStatus& stat = stats[i];
+        if (inodes.empty() || inodes.back().device != stat.device || inodes.back().inode != stat.inode)
+            inodes.push_back({ stat.size, stat.device, stat.inode, {}, 0, {}, false });
+        inodes.back().paths.push_back(i);
+    }
+
+    Vec<size_t> items(inodes.size());
+    for (size_t i = 0; i < items.size(); ++i)
+        items[i] = i;
+
+    auto pathOf = [&](size_t i) -> const String& { return files[inodes[i].paths[0]]; };
+    bool isOrdered = order != ReadOrder::Listing;
+
+    // By the size.
+    _keepDuplicated(items, [&](size_t i) { return inodes[i].size; });
+
+    if (isOrdered)
+        _sortByReadOrder(items, order, pathOf, executor);
+
+    // By the hash of the ends, the small files are fully hashed in the next stage directly.
+    parallelFor(items.size(), [&](size_t i)
+    {
+        Inode& inode = inodes[items[i]];
+        if (token.isCancelled())
+        {
+            inode.isFailed = true;
+        }
+        else if (inode.size > 2 * _DUPLICATE_PROBE_SIZE)
+        {
+            if (isOrdered && i + _READAHEAD_COUNT < items.size())
+            {
+                const Inode& next = inodes[items[i + _READAHEAD_COUNT]];
+                if (next.size > 2 * _DUPLICATE_PROBE_SIZE)
+                {
+                    _readahead(pathOf(items[i + _READAHEAD_COUNT]), 0, _DUPLICATE_PROBE_SIZE);
+                    _readahead(pathOf(items[i + _READAHEAD_COUNT]), next.size - _DUPLICATE_PROBE_SIZE,
+                               _DUPLICATE_PROBE_SIZE);
+                }
+            }
+
+            std::error_code ec;
+            inode.endsHash = _hashFileEnds(files[inode.paths[0]], inode.size, ec);
+            inode.isFailed = static_cast<bool>(ec);
+            bytes += 2 * _DUPLICATE_PROBE_SIZE;
+        }
+    }, executor);
+
+    items.erase(std::remove_if(items.begin(), items.end(), [&](size_t i) { return inodes[i].isFailed; }), items.end());
+    _keepDuplicated(items, [&](size_t i) { return std::make_tuple(inodes[i].size, inodes[i].endsHash); });
+
+    if (isOrdered)
+        _sortByReadOrder(items, order, pathOf, executor);
+
+    // By the hash of the full contents.
+    parallelFor(items.size(), [&](size_t i)
+    {
+        Inode& inode = inodes[items[i]];
+        if (token.isCancelled())
+        {
+            inode.isFailed = true;
+            return;
+        }
+
+        if (isOrdered && i + _READAHEAD_COUNT < items.size())
+            _readahead(pathOf(items[i + _READAHEAD_COUNT]), 0, inodes[items[i + _READAHEAD_COUNT]].size);
+
+        std::error_code ec;
+        inode.hash = _hashFileContents(files[inode.paths[0]], ec);
+        inode.isFailed = static_cast<bool>(ec);
+        bytes += inode.size;
+    }, executor);
+
+    items.erase(std::remove_if(items.begin(), items.end(), [&](size_t i) { return inodes[i].isFailed; }), items.end());
+    auto key = [&](size_t i) { return std::make_tuple(inodes[i].size, inodes[i].hash.first, inodes[i].hash.second); };
+    _keepDuplicated(items, key);
+
+    Vec<DuplicateGroup> rslt;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        const Inode& inode = inodes[items[i]];
+        if (i == 0 || key(items[i - 1]) != key(items[i]))
+        {
+            rslt.emplace_back();
+            rslt.back().size = inode.size;
+        }
+
+        for (size_t path : inode.paths)
+        {
+            rslt.back().paths.push_back(files[path]);
+            rslt.back().stats.push_back(stats[path]);
+        }
+    }
+
+    std::reverse(rslt.begin(), rslt.end());
+
+    OperationStats _stats;
+    _stats.entries = entries;
+    _stats.bytes = bytes;
+    _finishStats(opStats, _stats, token, start);
+
+    return rslt;
+}
+
+WFS_API Vec<DuplicateGroup> findDuplicates(const Strings& files, size_t minSize, Executor* executor,
+                                           const CancelToken& token, OperationStats* stats)
+{
+    return findDuplicates(files, minSize, executor, ReadOrder::Listing, token, stats);
+}
+
+WFS_API Vec<DuplicateGroup> findDuplicates(const Strings& files, size_t minSize, Executor* executor, ReadOrder order)
+{
+    return findDuplicates(files, minSize, executor, order, CancelToken(), nullptr);
+}
+
+/// @brief Replace the dst by a hardlink of the src atomically.
+WFS_API void _replaceByHardlink(const String& src, const String& dst, std::error_code& ec)
+{
+    static std::atomic<size_t> counter(0);
+
+    ec.clear();
+
+#ifdef _WRAPPED_FILESYS_POSIX
+    String temp = _fmt("{}.{}-{}.wfs-dedup", dst, static_cast<long long>(::getpid()), counter++);
+
+    if (::link(src.c_str(), temp.c_str()) != 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        return;
+    }
+
+    if (::rename(temp.c_str(), dst.c_str()) != 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        ::unlink(temp.c_str());
+    }
+#else
+    String temp = _fmt("{}.{}.wfs-dedup", dst, counter++);
+
+    fs::create_hard_link(src, temp, ec);
+    if (ec)
+        return;
+
+    fs::rename(temp, dst, ec);
+    if (ec)
+    {
+        std::error_code _ec;
+        fs::remove(temp, _ec);
+    }
+#endif // _WRAPPED_FILESYS_POSIX
+}
+
+/// @brief Share the extents of the src with the dst, the contents are verified by the kernel.
+WFS_API void _dedupeRange(const String& src, const String& dst, size_t size, std::error_code& ec)
+{
+    ec.clear();
+
+#if defined(__linux__) && defined(FIDEDUPERANGE)
+    // Some filesystems limit the length of a request (e.g. 16 MiB of the Btrfs).
+    constexpr size_t maxLength = 16 << 20;
+
+    int srcFd = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+    if (srcFd < 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        return;
+    }
+
+    int dstFd = ::open(dst.c_str(), O_RDWR | O_CLOEXEC);
+    if (dstFd < 0)
+        dstFd = ::open(dst.c_str(), O_RDONLY | O_CLOEXEC);
+    if (dstFd < 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        ::close(srcFd);
+        return;
+    }
+
+    alignas(struct file_dedupe_range) char buffer[sizeof(struct file_dedupe_range) +
+                                                  sizeof(struct file_dedupe_range_info)];
+    auto* range = reinterpret_cast<struct file_dedupe_range*>(buffer);
+    auto* info = reinterpret_cast<struct file_dedupe_range_info*>(buffer + sizeof(struct file_dedupe_range));
+
+    for (size_t offset = 0; offset < size;)
+    {
+        std::memset(buffer, 0, sizeof(buffer));
+        range->src_offset = offset;
+        range->src_length = std::min(size - offset, maxLength);
+        range->dest_count = 1;
+        info->dest_fd = dstFd;
+        info->dest_offset = offset;
+
+        if (::ioctl(srcFd, FIDEDUPERANGE, range) != 0)
+        {
+            ec = std::error_code(errno, std::generic_category());
+            break;
+        }
+
+        if (info->status == FILE_DEDUPE_RANGE_DIFFERS)
+        {
+            ec = std::make_error_code(std::errc::operation_canceled);   // The contents are changed.
+            break;
+        }
+
+        if (info->status < 0 || info->bytes_deduped == 0)
+        {
+            ec = std::error_code(info->status < 0 ? -info->status : EIO, std::generic_category());
+            break;
+        }
+
+        offset += info->bytes_deduped;
+    }
+
+    ::close(dstFd);
+    ::close(srcFd);
+#else
+    (void) src;
+    (void) dst;
+    (void) size;
+    ec = std::make_error_code(std::errc::operation_not_supported);
+#endif // __linux__ && FIDEDUPERANGE
+}
+
+WFS_API DedupReport deduplicate(const Vec<DuplicateGroup>& groups, DedupMethod method, bool isDryRun,
+                                Executor* executor, const CancelToken& token, OperationStats* stats)
+{
+    auto start = std::chrono::steady_clock::now();
+    DedupReport rslt;
+    std::mutex mutex;
+
+    parallelFor(groups.size(), [&](size_t index)
+    {
+        const DuplicateGroup& group = groups[index];
+        if (group.paths.size() < 2 || token.isCancelled())
+            return;
+
+        DedupReport report;
+        std::error_code ec;
+
+        Vec<FileStatus> statuses(group.paths.size());
+        for (size_t i = 0; i < statuses.size(); ++i)
+            statuses[i] = lstatus(group.paths[i], ec);
+
+        const FileStatus& keeper = statuses[0];
+        bool isStamped = group.stats.size() == group.paths.size();
+
+        // The file edited after the duplicates found may have the same size, so the stamps are compared too.
+        auto isUnchanged = [&](size_t i) -> bool
+        {
+            if (!isStamped)
+                return true;
+
+            const FileStatus& found = group.stats[i];
+            return statuses[i].device == found.device && statuses[i].inode == found.inode &&
+                   statuses[i].mtime == found.mtime && statuses[i].ctime == found.ctime;
+        };
+        auto isValid = [&](size_t i)
+        {
+            return statuses[i].isFile() && statuses[i].size == group.size && isUnchanged(i);
+        };
+        auto isKeeper = [&](size_t i)
+        {
+            return statuses[i].device == keeper.device && statuses[i].inode == keeper.inode;
+        };
+
+        // The count and the remaining count of the links in the group of each inode,
+        // the data is reclaimed when all the links of the inode are in the group and replaced.
+        std::map<std::pair<uint64_t, uint64_t>, std::pair<size_t, size_t>> links;
+        for (size_t i = 1; i < statuses.size(); ++i)
+        {
+            if (isValid(0) && isValid(i) && !isKeeper(i))
+            {
+                auto& link = links[std::make_pair(statuses[i].device, statuses[i].inode)];
+                ++link.first;
+                ++link.second;
+            }
+        }
+
+        for (size_t i = 1; i < statuses.size(); ++i)
+        {
+            const FileStatus& stat = statuses[i];
+            const String& path = group.paths[i];
+
+            if (!isValid(0) || !isValid(i) || (method == DedupMethod::Hardlink && stat.device != keeper.device))
+            {
+                report.failedPaths.push_back(path);
+                continue;
+            }
+
+            if (isKeeper(i))
+                continue;
+
+            auto link = links.find(std::make_pair(stat.device, stat.inode));
+
+            if (method == DedupMethod::Hardlink)
+            {
+                // The data of the path is dropped by the link, so the contents are compared byte by byte first
+                // (the hash may collide, and a write may keep the mtime).
+                if (!_isSameFileContents(group.paths[0], path, group.size, ec))
+                {
+                    report.failedPaths.push_back(path);
+                    continue;
+                }
+
+                if (!isDryRun)
+                    _replaceByHardlink(group.paths[0], path, ec);
+
+                if (!isDryRun && ec)
+                {
+                    report.failedPaths.push_back(path);
+                    continue;
+                }
+
+                ++report.replacedCount;
+                if (--link->second.second == 0 && stat.nlink == link->second.first)
+                    report.reclaimedBytes += group.size;
+            }
+            else
+            {
+                // The extents are shared by all the hardlinks of the inode, so just dedupe once.
+                if (link->second.second == 0)
+                    continue;
+                link->second.second = 0;
+
+                if (!isDryRun)
+                    _dedupeRange(group.paths[0], path, group.size, ec);
+
+                if (!isDryRun && ec)
+                {
+                    report.failedPaths.push_back(path);
+                    continue;
+                }
+
+                ++report.replacedCount;
+                report.reclaimedBytes += group.size;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        rslt.replacedCount += report.replacedCount;
+        rslt.reclaimedBytes += report.reclaimedBytes;
+        rslt.failedPaths.insert(rslt.failedPaths.end(), report.failedPaths.begin(), report.failedPaths.end());
+    }, executor != nullptr ? executor : &ioExecutor());
+
+    OperationStats _stats;
+    _stats.entries = rslt.replacedCount;
+    _stats.bytes = rslt.reclaimedBytes;
+    _stats.errors = rslt.failedPaths.size();
+    _finishStats(stats, _stats, token, start);
+
+    return rslt;
+}
+
+WFS_API DedupReport deduplicate(const Vec<DuplicateGroup>& groups, DedupMethod method, bool isDryRun,
+                                Executor* executor)
+{
+    return deduplicate(groups, method, isDryRun, executor, CancelToken(), nullptr);
+}
+
+/// @brief Read the whole file into the buffer (replace the contents).
+WFS_API void _readFile(String& buffer, const String& path, std::error_code& ec)
+{
+    ec.clear();
+    buffer.clear();
+
+#ifdef _WRAPPED_FILESYS_POSIX
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        return;
+    }
+
+    struct stat st;
+    size_t size = ::fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+
+    // Read one more byte to detect the growth of the file (or the unknown size of the special files).
+    size_t pos = 0;
+    buffer.resize(size + 1);
+
+    while (true)
+    {
+        ssize_t len = _preadAll(fd, &buffer[pos], buffer.size() - pos, pos);
+        if (len < 0)
+        {
+            ec = std::error_code(errno, std::generic_category());
+            break;
+        }
+
+        pos += static_cast<size_t>(len);
+        if (pos < buffer.size())
+            break;
+
+        buffer.resize(buffer.size() * 2);
+    }
+
+    buffer.resize(pos);
+    ::close(fd);
+#else
+    std::ifstream ifs(path, std::ios_base::binary);
+    if (!ifs)
+    {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return;
+    }
+
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    buffer = oss.str();
+#endif // _WRAPPED_FILESYS_POSIX
+
+    if (ec)
+        buffer.clear();
+}
+
+/// @brief Read the range of the file into the buffer (replace the contents), clipped by the end of the file.
+/// @param isFromEnd If true, the offset is ignored and the last bytes (at most the length) are read.
+WFS_API void _readRange(String& buffer, const String& path, size_t offset, size_t length, bool isFromEnd,
+                        std::error_code& ec)
+{
+    ec.clear();
+    buffer.clear();
+
+#ifdef _WRAPPED_FILESYS_POSIX
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        return;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ec = std::error_code(errno, std::generic_category());
+        ::close(fd);
+        return;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+
+    // The size of the special files is unknown (include the regular files of the procfs and sysfs, the size is 0).
+    bool isSized = S_ISREG(st.st_mode) && size > 0;
+
+    if (isFromEnd)
+        offset = size > length ? size - length : 0;
+
+    // The file with the size is read at once, the others are read by the chunks.
+    size_t count = isSized ? std::min(length, size > offset ? size - offset : 0) : length;
+    size_t pos = 0;
+
+    while (pos < count)
+    {
+        buffer.resize(isSized ? count : std::min(count, std::max<size_t>(2 * pos, 4096)));
+
+        ssize_t len = _preadAll(fd, &buffer[pos], buffer.size() - pos, offset + pos);
+        if (len < 0)
+        {
+            ec = std::error_code(errno, std::generic_category());
+            break;
+        }
+
+        pos += static_cast<size_t>(len);
+        if (pos < buffer.size())
+            break;
+    }
+
+    buffer.resize(pos);
+    ::close(fd);
+#else
+    std::ifstream ifs(path, std::ios_base::binary | std::ios_base::ate);
+    if (!ifs)
+    {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return;
+    }
+
+    size_t size = static_cast<size_t>(ifs.tellg());
+    if (isFromEnd)
+        offset = size > length ? size - length : 0;
+
+    size_t count = std::min(length, size > offset ? size - offset : 0);
+    buffer.resize(count);
+
+    ifs.seekg(static_cast<std::streamoff>(offset));
+    ifs.read(&buffer[0], static_cast<std::streamsize>(count));
+    buffer.resize(static_cast<size_t>(ifs.gcount()));
+
+    if (ifs.bad())
+        ec = std::make_error_code(std::errc::io_error);
+#endif // _WRAPPED_FILESYS_POSIX
+}
+
+WFS_API String readFileRange(const String& path, size_t offset, size_t length, std::error_code& ec)
+{
+    String rslt;
+    _readRange(rslt, path, offset, length, false, ec);
+    return rslt;
+}
+
+WFS_API String readFileHead(const String& path, size_t length, std::error_code& ec)
+{
+    return readFileRange(path, 0, length, ec);
+}
+
+WFS_API String readFileTail(const String& path, size_t length, std::error_code& ec)
+{
+    String rslt;
+    _readRange(rslt, path, 0, length, true, ec);
+    return rslt;
+}
+
+WFS_API String readFileRange(const String& path, size_t offset, size_t length)
+{
+    std::error_code ec;
+    String rslt = readFileRange(path, offset, length, ec);
+    if (ec)
+        throw Exception(_fmt("Failed to read the file: \"{}\" ({})", path, ec.message()));
+
+    return rslt;
+}
+
+WFS_API String readFileHead(const String& path, size_t length)
+{
+    return readFileRange(path, 0, length);
+}
+
+WFS_API String readFileTail(const String& path, size_t length)
+{
+    std::error_code ec;
+    String rslt = readFileTail(path, length, ec);
+    if (ec)
+        throw Exception(_fmt("Failed to read the file: \"{}\" ({})", path, ec.message()));
+
+    return rslt;
+}
+
+/// @brief The capacity of an arena block of the LoadedFiles.
+constexpr size_t _LOADED_BLOCK_SIZE = 4 << 20;
+
+/// @brief Append the contents of the file to the last block of the arena, or to a new block if it's full.
+WFS_API void _appendLoadedFile(LoadedFiles& loaded, size_t index, const char* data, size_t size)
+{
+    if (size == 0)
+        return;
+
+    if (loaded.blocks.empty() || loaded.blocks.back().capacity() - loaded.blocks.back().size() < size)
+    {
+        loaded.blocks.emplace_back();
+        loaded.blocks.back().reserve(std::max(_LOADED_BLOCK_SIZE, size));
+    }
+
+    String& block = loaded.blocks.back();
+    loaded.blockIndices[index] = loaded.blocks.size() - 1;
+    loaded.offsets[index] = block.size();
+    loaded.sizes[index] = size;
+    block.append(data, size);
+}
+
+#ifdef _WRAPPED_FILESYS_IO_URING
+
+/// @brief The minimal io_uring by the raw syscalls (no liburing dependency).
+class _IoUring
+{
+public:
+    explicit _IoUring(unsigned entries)
+    {
+        struct io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0)
+            return;
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        bool isSingleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (isSingleMmap)
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+        sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                         IORING_OFF_SQ_RING);
+        cqRing_ = isSingleMmap ? sqRing_ : ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                                                  MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+        sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+        void* sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                            IORING_OFF_SQES);
+
+        if (sqRing_ == MAP_FAILED || cqRing_ == MAP_FAILED || sqes == MAP_FAILED)
+        {
+            sqes_ = sqes == MAP_FAILED ? nullptr : static_cast<struct io_uring_sqe*>(sqes);
+            release_();
+            return;
+        }
+
+        char* sq = static_cast<char*>(sqRing_);
+        char* cq = static_cast<char*>(cqRing_);
+
+        sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqEntries_ = params.sq_entries;
+        sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        sqLocalTail_ = *sqTail_;
+    }
+
+    ~_IoUring() { close(); }
+
+    _IoUring(const _IoUring&) = delete;
+
+    _IoUring& operator=(const _IoUring&) = delete;
+
+    bool isValid() const { return fd_ >= 0; }
+
+    /// @brief Close the ring, the inflight operations are cancelled and the registered resources are released.
+    void close() { release_(); }
+
+    /// @return The cleared sqe to fill, nullptr if the submission queue is full.
+    struct io_uring_sqe* sqe()
+    {
+        unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if (sqLocalTail_ - head >= sqEntries_)
+            return nullptr;
+
+        unsigned index = sqLocalTail_ & sqMask_;
+        ++sqLocalTail_;
+
+        sqArray_[index] = index;
+        std::memset(&sqes_[index], 0, sizeof(struct io_uring_sqe));
+        return &sqes_[index];
+    }
+
+    /// @brief Submit the filled sqes and wait at least the count of the completions.
+    /// @return The count of the sqes submitted, -1 if failed (the errno is set).
+    int submit(unsigned waitCount)
+    {
+        __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+
+        unsigned count = sqLocalTail_ - sqSubmitted_;
+        int rslt = static_cast<int>(::syscall(__NR_io_uring_enter, fd_, count, waitCount,
+                                              waitCount > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+        if (rslt > 0)
+            sqSubmitted_ += static_cast<unsigned>(rslt);
+
+        return rslt;
+    }
+
+    /// @brief Wait at least the count of the completions without submitting (the sqes may be submitted by another
+    /// thread meanwhile).
+    /// @return 0 if succeeded, -1 if failed (the errno is set).
+    int wait(unsigned waitCount)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd_, 0, waitCount, IORING_ENTER_GETEVENTS,
+                                          nullptr, 0));
+    }
+
+    /// @brief Call the func for each completion.
+    template <typename Func>
+    void reap(Func func)
+    {
+        unsigned head = *cqHead_;
+        unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; ++head)
+            func(cqes_[head & cqMask_]);
+
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    }
+
+    int registerBuffers(const struct iovec* iovs, unsigned count)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, iovs, count));
+    }
+
+    int registerFiles(const int* fds, unsigned count)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_FILES, fds, count));
+    }
+
+private:
+    void release_()
+    {
+        if (sqes_ != nullptr)
+            ::munmap(sqes_, sqesSize_);
+        if (cqRing_ != nullptr && cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+            ::munmap(cqRing_, cqRingSize_);
+        if (sqRing_ != nullptr && sqRing_ != MAP_FAILED)
+            ::munmap(sqRing_, sqRingSize_);
+        if (fd_ >= 0)
+            ::close(fd_);
+
+        sqes_ = nullptr;
+        cqRing_ = nullptr;
+        sqRing_ = nullptr;
+        fd_ = -1;
+    }
+
+    int fd_ = -1;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    size_t sqesSize_ = 0;
+
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqEntries_ = 0;
+    unsigned sqLocalTail_ = 0;
+    unsigned sqSubmitted_ = 0;
+    struct io_uring_sqe* sqes_ = nullptr;
+
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    struct io_uring_cqe* cqes_ = nullptr;
+};
+
+/// @brief Load the files by the io_uring, each file is opened into a direct descriptor slot, read into the
+/// registered buffer of the slot and closed, by the linked sqes.
+/// @param indices The indices of the files to load, by the order to submit.
+/// @param offset, length The range of each file to load.
+/// @param fallback The indices of the files should be loaded by the other way (too large or not supported).
+/// @return If the io_uring is available (else nothing is loaded).
+WFS_API bool _loadFilesByIoUring(const Strings& paths, const Vec<size_t>& indices, size_t offset, size_t length,
+                                 LoadedFiles& rslt, Vec<size_t>& fallback)
+{
+    constexpr unsigned slotCount = 64;
+    constexpr size_t bufferSize = 64 << 10;
+    constexpr uint64_t opOpen = 0, opRead = 1, opClose = 2;
+
+    _IoUring ring(slotCount * 3);
+    if (!ring.isValid())
+        return false;
+
+    void* buffers = ::mmap(nullptr, slotCount * bufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffers == MAP_FAILED)
+        return false;
+
+    struct iovec iovs[slotCount];
+    int fds[slotCount];
+    for (unsigned i = 0; i < slotCount; ++i)
+    {
+        iovs[i].iov_base = static_cast<char*>(buffers) + i * bufferSize;
+        iovs[i].iov_len = bufferSize;
+        fds[i] = -1;
+    }
+
+    if (ring.registerBuffers(iovs, slotCount) != 0 || ring.registerFiles(fds, slotCount) != 0)
+    {
+        ::munmap(buffers, slotCount * bufferSize);
+        return false;
+    }
+
+    struct Slot
+    {
+        size_t file;
+        int openRslt;
+        int readRslt;
+        unsigned completed;
+    };
+
+    Slot slots[slotCount];
+    Vec<unsigned> freeSlots;
+    for (unsigned i = slotCount; i > 0; --i)
+        freeSlots.push_back(i - 1);
+
+    // The errors mean the operations are not supported by the kernel, so fall back.
+    auto isUnsupported = [](int err) { return err == -EINVAL || err == -EOPNOTSUPP || err == -EBADF || err == -ENOSYS; };
+
+    auto finish = [&](unsigned slot)
+    {
+        const Slot& _slot = slots[slot];
+        int err = _slot.openRslt < 0 ? _slot.openRslt : (_slot.readRslt < 0 ? _slot.readRslt : 0);
+
+        bool isTruncated = length > bufferSize && static_cast<size_t>(_slot.readRslt) == bufferSize;
+        if (isUnsupported(err) || (err == 0 && isTruncated))
+        {
+            fallback.push_back(_slot.file);
+        }
+        else if (err != 0)
+        {
+            rslt.errors[_slot.file] = std::error_code(-err, std::generic_category());
+        }
+        else
+        {
+            _appendLoadedFile(rslt, _slot.file, static_cast<const char*>(iovs[slot].iov_base),
+                              static_cast<size_t>(_slot.readRslt));
+        }
+
+        freeSlots.push_back(slot);
+    };
+
+    size_t next = 0;
+    size_t inflight = 0;
+
+    while (next < indices.size() || inflight > 0)
+    {
+        for (; !freeSlots.empty() && next < indices.size(); ++next, ++inflight)
+        {
+            unsigned slot = freeSlots.back();
+            freeSlots.pop_back();
+            slots[slot] = { indices[next], 0, 0, 0 };
+
+            struct io_uring_sqe* sqe = ring.sqe();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->flags = IOSQE_IO_LINK;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uint64_t>(paths[indices[next]].c_str());
+            // The direct descriptor is never inherited, and the O_CLOEXEC is rejected for it.
+            sqe->open_flags = O_RDONLY;
+            sqe->file_index = slot + 1;
+            sqe->user_data = slot * 4 + opOpen;
+
+            // The close is hard linked, so the slot is closed even if the read is failed.
+            sqe = ring.sqe();
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+            sqe->fd = static_cast<int>(slot);
+            sqe->addr = reinterpret_cast<uint64_t>(iovs[slot].iov_base);
+            sqe->len = static_cast<unsigned>(std::min(bufferSize, length));
+            sqe->off = offset;
+            sqe->buf_index = static_cast<uint16_t>(slot);
+            sqe->user_data = slot * 4 + opRead;
+
+            sqe = ring.sqe();
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->file_index = slot + 1;
+            sqe->user_data = slot * 4 + opClose;
+        }
+
+        if (ring.submit(1) < 0 && errno != EINTR)
+        {
+            // The ring is broken, fall back the files not completed (the inflight ones are completed or cancelled
+            // when the ring is closed, and their buffers are not used anymore).
+            for (unsigned i = 0; i < slotCount; ++i)
+            {
+                if (std::find(freeSlots.begin(), freeSlots.end(), i) == freeSlots.end())
+                    fallback.push_back(slots[i].file);
+            }
+            for (; next < indices.size(); ++next)
+                fallback.push_back(indices[next]);
+
+            inflight = 0;
+            break;
+        }
+
+        ring.reap([&](const struct io_uring_cqe& cqe)
+        {
+            unsigned slot = static_cast<unsigned>(cqe.user_data / 4);
+            uint64_t op = cqe.user_data % 4;
+
+            if (op == opOpen)
+                slots[slot].openRslt = cqe.res;
+            else if (op == opRead)
+                slots[slot].readRslt = cqe.res;
+
+            if (++slots[slot].completed == 3)
+            {
+                finish(slot);
+                --inflight;
+            }
+        });
+    }
+
+    // Close the ring before the buffers are unmapped.
+    ring.close();
+    ::munmap(buffers, slotCount * bufferSize);
+
+    return true;
+}
+
+/// @brief The process-wide io_uring to read the whole files without blocking any thread, see the _readFilesAsync().
+/// The sqes are submitted by the callers and the completion thread (guarded by the mutex), the completion thread
+/// handles each completion by issuing the next step of the file (open, then read until the end).
+class _IoUringReactor
+{
+public:
+    using Callback = std::function<void(Strings&, Vec<std::error_code>&)>;
+
+    /// @return The reactor, nullptr if the io_uring is not available.
+    static _IoUringReactor* instance()
+    {
+        static _IoUringReactor reactor;
+        return reactor.thread_.joinable() && !reactor.isUnsupported_ ? &reactor : nullptr;
+    }
+
+    ~_IoUringReactor()
+    {
+        if (!thread_.joinable())
+            return;
+
+        // The nop with the zero user data stops the completion thread. It is retried until submitted (the completion
+        // thread reaps meanwhile), unless the completion thread is exited already.
+        bool isQueued = false;
+        while (!isExited_)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!isQueued)
+                {
+                    struct io_uring_sqe* sqe = sqe_();
+                    if (sqe != nullptr)
+                    {
+                        sqe->opcode = IORING_OP_NOP;
+                        isQueued = true;
+                    }
+                }
+                if (isQueued && ring_.submit(0) >= 0)
+                    break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        thread_.join();
+    }
+
+    _IoUringReactor(const _IoUringReactor&) = delete;
+
+    _IoUringReactor& operator=(const _IoUringReactor&) = delete;
+
+    /// @brief Read the whole files, the callback is called once when all files are completed.
+    /// @param executor The executor to read the files not supported by the io_uring.
+    /// @return False if the reactor is not usable anymore, and the callback is not called.
+    bool read(const Strings& paths, Executor* executor, Callback callback)
+    {
+        auto batch = std::make_shared<Batch_>();
+        batch->paths = paths;
+        batch->contents.resize(paths.size());
+        batch->errors.resize(paths.size());
+        batch->remaining = paths.size();
+        batch->executor = executor;
+        batch->callback = std::move(callback);
+
+        if (paths.empty())
+        {
+            batch->callback(batch->contents, batch->errors);
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (isUnsupported_)
+            return false;
+
+        for (size_t i = 0; i < paths.size(); ++i)
+            pending_.push_back(new Read_(batch, i));
+        pump_();
+        return true;
+    }
+
+private:
+    struct Batch_
+    {
+        Strings paths;
+        Strings contents;
+        Vec<std::error_code> errors;
+        std::atomic<size_t> remaining{ 0 };
+        Executor* executor = nullptr;
+        Callback callback;
+    };
+
+    struct Read_
+    {
+        Read_(std::shared_ptr<Batch_> batch, size_t index) : batch(std::move(batch)), index(index) {}
+
+        std::shared_ptr<Batch_> batch;
+        size_t index;
+        String buffer;
+        int fd = -1;
+        size_t pos = 0;
+        bool isRegular = false;
+    };
+
+    // Each file in flight has one sqe at most, so the completion queue (twice the entries) is never overflowed.
+    static constexpr unsigned maxInflight_ = 256;
+
+    _IoUringReactor() : ring_(maxInflight_)
+    {
+        if (ring_.isValid())
+            thread_ = std::thread([this]() { loop_(); });
+    }
+
+    /// @return The sqe to fill (the queue is flushed if full), nullptr if failed. The mutex is locked.
+    struct io_uring_sqe* sqe_()
+    {
+        struct io_uring_sqe* sqe = ring_.sqe();
+        if (sqe == nullptr && ring_.submit(0) >= 0)
+            sqe = ring_.sqe();
+        return sqe;
+    }
+
+    /// @brief Open the pending files while the count in flight is under the limit. The mutex is locked.
+    void pump_()
+    {
+        while (inflight_.size() < maxInflight_ && !pending_.empty())
+        {
+            struct io_uring_sqe* sqe = sqe_();
+            if (sqe == nullptr)
+                break;
+
+            Read_* file = pending_.front();
+            pending_.pop_front();
+            inflight_.insert(file);
+
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uint64_t>(file->batch->paths[file->index].c_str());
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = reinterpret_cast<uint64_t>(file);
+        }
+
+        ring_.submit(0);
+    }
+
+    /// @brief Read the next part of the file into the buffer, which is doubled if full.
+    void next_(Read_* file)
+    {
+        String& buffer = file->buffer;
+        if (file->pos == buffer.size())
+            buffer.resize(std::max<size_t>(buffer.size() * 2, 64 << 10));
+
+        bool isIssued = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            struct io_uring_sqe* sqe = sqe_();
+            if (sqe != nullptr)
+            {
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = file->fd;
+                sqe->addr = reinterpret_cast<uint64_t>(&buffer[file->pos]);
+                sqe->len = static_cast<unsigned>(std::min<size_t>(buffer.size() - file->pos, size_t(1) << 30));
+                sqe->off = file->pos;
+                sqe->user_data = reinterpret_cast<uint64_t>(file);
+                ring_.submit(0);
+                isIssued = true;
+            }
+        }
+
+        if (!isIssued)
+            finish_(file, EAGAIN);
+    }
+
+    /// @brief Handle the completion of the open or the read of the file.
+    void complete_(Read_* file, int rslt)
+    {
+        String& buffer = file->buffer;
+
+        if (file->fd < 0)
+        {
+            if (rslt < 0)
+            {
+                // The fixed flags are valid, so the open is not supported by the kernel.
+                if (rslt == -EINVAL)
+                    isUnsupported_ = true;
+                finish_(file, -rslt);
+                return;
+            }
+
+            file->fd = rslt;
+            struct stat st;
+            file->isRegular = ::fstat(file->fd, &st) == 0 && S_ISREG(st.st_mode);
+
+            // Read one more byte to detect the growth of the file, same as the _readFile().
+            buffer.resize(file->isRegular ? static_cast<size_t>(st.st_size) + 1 : 0);
+            next_(file);
+        }
+        else if (rslt == -EINTR || rslt == -EAGAIN)
+        {
+            next_(file);
+        }
+        else if (rslt < 0)
+        {
+            finish_(file, -rslt);
+        }
+        else
+        {
+            // The zero read is the end, and so is the short read of the regular file.
+            file->pos += static_cast<size_t>(rslt);
+            if (rslt == 0 || (file->isRegular && file->pos < buffer.size()))
+                finish_(file, 0);
+            else
+                next_(file);
+        }
+    }
+
+    /// @brief The file is completed (failed if the err is not zero), or read by the executor if not supported.
+    void finish_(Read_* file, int err)
+    {
+        if (file->fd >= 0)
+            ::close(file->fd);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            inflight_.erase(file);
+            pump_();
+        }
+
+        if (err == EINVAL || err == EOPNOTSUPP || err == ENOSYS)
+        {
+            fallback_(file);
+            return;
+        }
+
+        Batch_& batch = *file->batch;
+        if (err != 0)
+        {
+            batch.errors[file->index] = std::error_code(err, std::generic_category());
+        }
+        else
+        {
+            file->buffer.resize(file->pos);
+            batch.contents[file->index] = std::move(file->buffer);
+        }
+
+        release_(file);
+    }
+
+    /// @brief Read the file by the executor instead.
+    static void fallback_(Read_* file)
+    {
+        file->batch->executor->submit([file]()
+        {
+            Batch_& batch = *file->batch;
+            std::error_code ec;
+            _readFile(batch.contents[file->index], batch.paths[file->index], ec);
+            batch.errors[file->index] = ec;
+            release_(file);
+        });
+    }
+
+    /// @brief The ring is broken, so the reactor is marked unusable and the outstanding files are read by the
+    /// executors instead.
+    /// @note The kernel may still write the buffers or read the paths of the files in flight, so they are leaked
+    /// (with their batches), and retried by the new reads.
+    void abort_()
+    {
+        std::deque<Read_*> files;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isUnsupported_ = true;
+            files.swap(pending_);
+            for (Read_* file : inflight_)
+                files.push_back(new Read_(file->batch, file->index));
+            inflight_.clear();
+        }
+
+        for (Read_* file : files)
+            fallback_(file);
+    }
+
+    /// @brief Release the file, and call the callback if all files of the batch are completed.
+    static void release_(Read_* file)
+    {
+        std::shared_ptr<Batch_> batch = std::move(file->batch);
+        delete file;
+
+        if (--batch->remaining == 0)
+            batch->callback(batch->contents, batch->errors);
+    }
+
+    void loop_()
+    {
+        Vec<std::pair<uint64_t, int>> completions;
+
+        while (true)
+        {
+            if (ring_.wait(1) < 0 && errno != EINTR)
+            {
+                abort_();
+                isExited_ = true;
+                return;
+            }
+
+            // Reaped under the lock, so the completions are ordered after their submissions (also under the lock).
+            completions.clear();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ring_.reap([&](const struct io_uring_cqe& cqe) { completions.emplace_back(cqe.user_data, cqe.res); });
+            }
+
+            for (const auto& completion : completions)
+            {
+                if (completion.first == 0)
+                {
+                    isExited_ = true;
+                    return;
+                }
+                complete_(reinterpret_cast<Read_*>(completion.first), completion.second);
+            }
+        }
+    }
+
+    _IoUring ring_;
+    std::mutex mutex_;
+    std::deque<Read_*> pending_;
+    std::unordered_set<Read_*> inflight_;
+    std::atomic<bool> isUnsupported_{ false };
+    std::atomic<bool> isExited_{ false };
+    std::thread thread_;
+};
+
+#endif // _WRAPPED_FILESYS_IO_URING
+
+WFS_API void _readFilesAsync(const Strings& paths, Executor* executor,
+                             std::function<void(Strings&, Vec<std::error_code>&)> callback)
+{
+    if (executor == nullptr)
+        executor = &ioExecutor();
+
+#ifdef _WRAPPED_FILESYS_IO_URING
+    _IoUringReactor* reactor = _IoUringReactor::instance();
+    if (reactor != nullptr && reactor->read(paths, executor, callback))
+        return;
+#endif // _WRAPPED_FILESYS_IO_URING
+
+    executor->submit([paths, executor, callback]()
+    {
+        Strings contents(paths.size());
+        Vec<std::error_code> errors(paths.size());
+        parallelFor(paths.size(), [&](size_t i) { _readFile(contents[i], paths[i], errors[i]); }, executor);
+        callback(contents, errors);
+    });
+}
+
+/// @brief Load the range of each file, see the loadFiles(), loadFileRanges() and loadFileTails().
+/// @param isFromEnd If true, the offset is ignored and the last bytes (at most the length) are loaded.
+WFS_API LoadedFiles _loadFiles(const Strings& paths, size_t offset, size_t length, bool isFromEnd, Executor* executor,
+                               ReadOrder order)
+{
+    bool isWhole = offset == 0 && length == SIZE_MAX && !isFromEnd;
+
+    if (executor == nullptr)
+        executor = &ioExecutor();
+
+    LoadedFiles rslt;
+    rslt.blockIndices.assign(paths.size(), 0);
+    rslt.offsets.assign(paths.size(), 0);
+    rslt.sizes.assign(paths.size(), 0);
+    rslt.errors.assign(paths.size(), std::error_code());
+
+    Vec<size_t> indices(paths.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = i;
+
+    bool isOrdered = order != ReadOrder::Listing;
+    Vec<size_t> fileSizes;
+
+    if (isOrdered)
+    {
+        auto pathOf = [&](size_t i) -> const String& { return paths[i]; };
+        Vec<_ReadLocation> locations = _sortByReadOrder(indices, order, pathOf, executor);
+
+        fileSizes.resize(paths.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+            fileSizes[indices[i]] = locations[i].size;
+    }
+
+    Vec<size_t> fallback;
+    bool isLoaded = false;
+
+#ifdef _WRAPPED_FILESYS_IO_URING
+    if (!isFromEnd)
+        isLoaded = _loadFilesByIoUring(paths, indices, offset, length, rslt, fallback);
+#endif // _WRAPPED_FILESYS_IO_URING
+
+    if (!isLoaded)
+    {
+        fallback = indices;
+    }
+    else if (isOrdered)
+    {
+        // The fallback files are reported by the completion order, restore the read order.
+        Vec<char> isFallback(paths.size(), 0);
+        for (size_t i : fallback)
+            isFallback[i] = 1;
+
+        fallback.clear();
+        for (size_t i : indices)
+        {
+            if (isFallback[i])
+                fallback.push_back(i);
+        }
+    }
+
+    Strings contents(fallback.size());
+    parallelFor(fallback.size(), [&](size_t i)
+    {
+        if (isOrdered && i + _READAHEAD_COUNT < fallback.size())
+        {
+            size_t next = fallback[i + _READAHEAD_COUNT];
+            size_t size = fileSizes[next];
+            size_t _offset = isFromEnd ? (size > length ? size - length : 0) : offset;
+            if (_offset < size)
+                _readahead(paths[next], _offset, std::min(length, size - _offset));
+        }
+
+        if (isWhole)
+            _readFile(contents[i], paths[fallback[i]], rslt.errors[fallback[i]]);
+        else
+            _readRange(contents[i], paths[fallback[i]], offset, length, isFromEnd, rslt.errors[fallback[i]]);
+    }, executor);
+
+    // The large contents are moved as the blocks without copying, and the small ones are packed into the blocks.
+    for (size_t i = 0; i < fallback.size(); ++i)
+    {
+        if (contents[i].size() < _LOADED_BLOCK_SIZE / 64)
+        {
+            _appendLoadedFile(rslt, fallback[i], contents[i].data(), contents[i].size());
+            continue;
+        }
+
+        rslt.blockIndices[fallback[i]] = rslt.blocks.size();
+        rslt.sizes[fallback[i]] = contents[i].size();
+        rslt.blocks.push_back(std::move(contents[i]));
+    }
+
+    return rslt;
+}
+
+WFS_API LoadedFiles loadFiles(const Strings& paths, Executor* executor, ReadOrder order)
+{
+    return _loadFiles(paths, 0, SIZE_MAX, false, executor, order);
+}
+
+WFS_API LoadedFiles loadFileRanges(const Strings& paths, size_t offset, size_t length, Executor* executor,
+                                   ReadOrder order)
+{
+    return _loadFiles(paths, offset, length, false, executor, order);
+}
+
+WFS_API LoadedFiles loadFileTails(const Strings& paths, size_t length, Executor* executor, ReadOrder order)
+{
+    return _loadFiles(paths, 0, length, true, executor, order);
+}
+
+#endif // !WFS_FWD
+
+} // namespace wfs
+
+// Declaration of the directory watching functions.
+// (Based on the inotify in Linux, not supported in other platforms.)
+namespace wfs
+{
+
+/// @brief The change of a watched directory.
+struct _WatchEvent
+{
+    /// @brief The watch descriptor, -1 if the event queue is overflowed (some changes are lost).
+    int wd;
+    /// @brief The changed entry name, empty if the directory itself changed.
+    String name;
+    /// @brief If true, the paths under the changed one are also changed (a directory is moved or deleted).
+    bool isTree;
+};
+
+#ifndef WFS_IMPL
+
+/// @brief Open a directory watcher.
+/// @return The handle of the watcher, -1 if not supported or failed.
+WFS_API int _watcherOpen();
+
+/// @brief Watch the entries of the directory (not recursive).
+/// @return The watch descriptor, -1 if failed.
+WFS_API int _watcherAdd(int watcher, const String& dir);
+
+/// @brief Wait the changes at most the timeout.
+WFS_API Vec<_WatchEvent> _watcherRead(int watcher, int timeoutMs);
+
+WFS_API void _watcherClose(int watcher);
+
+#endif // !WFS_IMPL
+
+} // namespace wfs
+
+// Implementation of the directory watching functions.
+namespace wfs
+{
+
+#ifndef WFS_FWD
+
+WFS_API int _watcherOpen()
+{
+#ifdef __linux__
+    return ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+#else
+    return -1;
+#endif // __linux__
+}
+
+WFS_API int _watcherAdd(int watcher, const String& dir)
+{
+#ifdef __linux__
+    uint32_t mask = IN_ATTRIB | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MODIFY |
+                    IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+    return ::inotify_add_watch(watcher, dir.c_str(), mask);
+#else
+    (void) watcher;
+    (void) dir;
+    return -1;
+#endif // __linux__
+}
+
+WFS_API Vec<_WatchEvent> _watcherRead(int watcher, int timeoutMs)
+{
+    Vec<_WatchEvent> rslt;
+
+#ifdef __linux__
+    struct pollfd pfd = { watcher, POLLIN, 0 };
+    if (::poll(&pfd, 1, timeoutMs) <= 0)
+        return rslt;
+
+    alignas(struct inotify_event) char buffer[4096];
+    while (true)
+    {
+        ssize_t len = ::read(watcher, buffer, sizeof(buffer));
+        if (len <= 0)
+            break;
+
+        for (ssize_t pos = 0; pos < len;)
+        {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + pos);
+
+            bool isTree = (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) ||
+                          ((event->mask & IN_ISDIR) && (event->mask & (IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)));
+
+            if (event->mask & IN_Q_OVERFLOW)
+                rslt.push_back({ -1, String(), true });
+            else
+                rslt.push_back({ event->wd, event->len > 0 ? String(event->name) : String(), isTree });
+
+            pos += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+        }
+    }
+#else
+    (void) watcher;
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+#endif // __linux__
+
+    return rslt;
+}
+
+WFS_API void _watcherClose(int watcher)
+{
+#ifdef __linux__
+    if (watcher >= 0)
+        ::close(watcher);
+#else
+    (void) watcher;
+#endif // __linux__
+}
+
+#endif // !WFS_FWD
+
+} // namespace wfs
+
+// Classes.
+namespace wfs
+{
+
+#ifndef WFS_IMPL
+
+class File
+{
+public:
+    File() = default;
+
+    ~File()
+    {
+        releaseData();
+        releaseBacking_();
+    }
+
+    File(const File& other)
+    {
+        name_ = other.name_;
+        lastAccess_.store(other.lastAccess(), std::memory_order_relaxed);
+        if (other.data_)
+            data_ = new String(*other.data_);
+        if (other.backingPath_)
+            backingPath_ = new String(*other.backingPath_);
+    }
+
+    File(File&& other) noexcept
+    {
+        name_ = other.name_;
+        lastAccess_.store(other.lastAccess(), std::memory_order_relaxed);
+        data_ = other.data_;
+        other.data_ = nullptr;
+        backingPath_ = other.backingPath_;
+        other.backingPath_ = nullptr;
+    }
+
+    File& operator=(const File& other)
+    {
+        if (this == &other)
+            return *this;
+
+        name_ = other.name_;
+        lastAccess_.store(other.lastAccess(), std::memory_order_relaxed);
+
+        releaseData();
+        if (other.data_)
+            data_ = new String(*other.data_);
+
+        releaseBacking_();
+        if (other.backingPath_)
+            backingPath_ = new String(*other.backingPath_);
+
+        return *this;
+    }
+
+    explicit File(const String& name) { setName(name); }
+
+    static File fromDiskPath(const String& filename)
+    {
+        IFStream ifs(filename, std::ios_base::binary);
+
+        if (!ifs.is_open())
+            throw Exception(_fmt("Failed to open the file: \"{}\"", filename));
+
+        // The buffer size is by the block size of the file.
+        std::error_code ec;
+        size_t blockSize = status(filename, ec).blockSize;
+
+        File file(filenameEx(filename));
+        file.read_(ifs, bufferSize(BufferUsage::Read, blockSize));
+
+        ifs.close();
+
+        return file;
+    }
+
+    /// @brief Load the range of the file only, by a pread(), see the readFileRange().
+    static File fromDiskPath(const String& filename, size_t offset, size_t length)
+    {
+        File file(filenameEx(filename));
+        file = readFileRange(filename, offset, length);
+        return file;
+    }
+
+    /// @brief Load the first bytes (at most the length) of the file only.
+    static File fromDiskPathHead(const String& filename, size_t length)
+    {
+        return fromDiskPath(filename, 0, length);
+    }
+
+    /// @brief Load the last bytes (at most the length) of the file only.
+    static File fromDiskPathTail(const String& filename, size_t length)
+    {
+        File file(filenameEx(filename));
+        file = readFileTail(filename, length);
+        return file;
+    }
+
+    /// @brief The file backed by the disk file lazily, the data is not loaded until it's modified or load()ed,
+    /// and the readAt() reads the range of the disk file only.
+    /// @note The disk file should not be changed while the file is lazy.
+    static File fromDiskPathLazy(const String& filename)
+    {
+        if (!isFile(filename))
+            throw Exception(_fmt("Failed to open the file: \"{}\"", filename));
+
+        File file(filenameEx(filename));
+        file.backingPath_ = new String(filename);
+        return file;
+    }
+
+    /// @brief Load the files by the loadFiles() (by the io_uring in Linux if available).
+    /// @param executor The executor to read the files not loaded by the io_uring, nullptr means the ioExecutor().
+    static Vec<File> fromDiskPaths(const Strings& filenames, Executor* executor = nullptr)
+    {
+        return fromLoadedFiles_(filenames, loadFiles(filenames, executor));
+    }
+
+    /// @brief Load the same range of the files by the loadFileRanges().
+    static Vec<File> fromDiskPaths(const Strings& filenames, size_t offset, size_t length, Executor* executor = nullptr)
+    {
+        return fromLoadedFiles_(filenames, loadFileRanges(filenames, offset, length, executor));
+    }
+
+    File copy() const { return File(*this); }
+
+    String name() const { return name_; }
+
+    /// @note The whole disk file is read if it's lazy (but not loaded).
+    String data() const
+    {
+        touch_();
+
+        if (data_)
+            return *data_;
+        if (backingPath_)
+            return readFileRange(*backingPath_, 0, SIZE_MAX);
+
+        return "";
+    }
+
+    /// @brief Read the range of the data (clipped by the end), the lazy file reads the range of the disk file only.
+    String readAt(size_t offset, size_t length) const
+    {
+        touch_();
+
+        if (data_)
+            return offset < data_->size() ? data_->substr(offset, length) : String();
+        if (backingPath_)
+            return readFileRange(*backingPath_, offset, length);
+
+        return "";
+    }
+
+    /// @return If the data is backed by the disk file and not loaded.
+    bool isLazy() const { return backingPath_ != nullptr; }
+
+    /// @return The path of the disk file backs the data, empty if not lazy.
+    String backingPath() const { return backingPath_ ? *backingPath_ : ""; }
+
+    /// @brief Load the data of the lazy file from the disk file, so it's not lazy anymore.
+    void load()
+    {
+        if (!backingPath_)
+            return;
+
+        String data = readFileRange(*backingPath_, 0, SIZE_MAX);
+        releaseBacking_();
+        releaseData();
+        data_ = new String(std::move(data));
+    }
+
+    /// @note The size of the disk file if it's lazy.
+    size_t size() const
+    {
+        if (data_)
+            return data_->size();
+        if (backingPath_)
+        {
+            std::error_code ec;
+            return status(*backingPath_, ec).size;
+        }
+
+        return 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /// @return The access tick of the last data access, the greater the more recently.
+    size_t lastAccess() const { return lastAccess_.load(std::memory_order_relaxed); }
+
+    /// @return The memory usage of this file (include the node structure itself).
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage;
+
+        usage.nodes = sizeof(File);
+        _accountName(usage, name_);
+
+        if (backingPath_)
+        {
+            usage.nodes += sizeof(String);
+            _accountName(usage, *backingPath_);
+        }
+
+        if (data_)
+        {
+            usage.contents = data_->size();
+
+            // The small data is stored inline of the string object by SSO.
+            if (_heapBytes(*data_) == 0)
+            {
+                usage.nodes += sizeof(String) - data_->size();
+            }
+            else
+            {
+                usage.nodes += sizeof(String);
+                usage.slack += _heapBytes(*data_) - data_->size();
+            }
+        }
+
+        return usage;
+    }
+
+    void setName(const String& name) { name_ = name; }
+
+    void releaseData()
+    {
+        if (data_)
+        {
+            delete data_;
+            data_ = nullptr;
+        }
+    }
+
+    void write(OStream& os) const
+    {
+        touch_();
+        if (data_)
+            os << *data_;
+        else if (backingPath_)
+            os << data();
+    }
+
+    void write(const String& path, bool isOverwrite = false,
+               std::ios_base::openmode openmode = std::ios_base::binary) const
+    {
+        String _path = pathcat(path, name_);
+
+        if (!isOverwrite && isFile(_path))
+            return;
+
+        // The lazy data is read before the stream truncates the target, which may be the backing file itself.
+        String lazyData = isLazy() ? data() : String();
+
+        std::ofstream ofs(_path.data(), openmode);
+
+        if (!ofs.is_open())
+            throw Exception(_fmt("Failed to open the file: \"{}\"", _path));
+
+        if (isLazy())
+            ofs << lazyData;
+        else
+            write(ofs);
+
+        ofs.close();
+    }
+
+    File& operator=(const String& data)
+    {
+        touch_();
+        releaseData();
+        releaseBacking_();
+        data_ = new String(data);
+        return *this;
+    }
+
+    File& operator=(String&& data)
+    {
+        touch_();
+        releaseData();
+        releaseBacking_();
+        data_ = new String(std::move(data));
+        return *this;
+    }
+
+    template <typename T>
+    File& operator=(const Vec<T>& data)
+    {
+        touch_();
+        releaseData();
+        releaseBacking_();
+
+        data_ = new String;
+        data_->reserve(data_->size() + data.size());
+
+        for (const auto& var : data)
+            data_->push_back(var);
+
+        return *this;
+    }
+
+    File& operator<<(const File& other)
+    {
+        load();
+        touch_();
+        if (!data_)
+            data_ = new String;
+        data_->append(other.data());
+
+        return *this;
+    }
+
+    File& operator<<(IStream& is)
+    {
+        read_(is, bufferSize(BufferUsage::Read));
+        return *this;
+    }
+
+    File& operator<<(const String& data)
+    {
+        load();
+        touch_();
+        if (!data_)
+            data_ = new String();
+        data_->append(data);
+
+        return *this;
+    }
+
+    template <typename T>
+    File& operator<<(const Vec<T>& data)
+    {
+        size_t size = data.size();
+
+        load();
+        touch_();
+        if (!data_)
+            data_ = new String;
+        data_->reserve(data_->size() + size);
+
+        for (const auto& var : data)
+            data_->push_back(var);
+
+        return *this;
+    }
+
+    const File& operator>>(OStream& os) const
+    {
+        write(os);
+        return *this;
+    }
+
+private:
+    /// @brief Mark the file data as the most recently accessed one.
+    void touch_() const
+    {
+        static std::atomic<size_t> tick(0);
+        lastAccess_.store(tick.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /// @brief Append the remaining data of the stream, read by the pooled buffer of the size.
+    void read_(IStream& is, size_t chunkSize)
+    {
+        load();
+
+        is.seekg(0, std::ios_base::end);
+        std::streamoff size = is.tellg();
+        is.seekg(0, std::ios_base::beg);
+
+        touch_();
+        if (!data_)
+            data_ = new String();
+        if (size > 0)
+            data_->reserve(data_->size() + static_cast<size_t>(size));
+
+        IoBuffer buffer(chunkSize);
+        while (is.read(buffer.data(), static_cast<std::streamsize>(buffer.size())))
+            data_->append(buffer.data(), static_cast<size_t>(is.gcount()));
+
+        data_->append(buffer.data(), static_cast<size_t>(is.gcount()));
+    }
+
+    void releaseBacking_()
+    {
+        delete backingPath_;
+        backingPath_ = nullptr;
+    }
+
+    static Vec<File> fromLoadedFiles_(const Strings& filenames, LoadedFiles loaded)
+    {
+        Vec<File> rslt;
+        rslt.reserve(filenames.size());
+
+        for (size_t i = 0; i < filenames.size(); ++i)
+        {
+            if (loaded.errors[i])
+                throw Exception(_fmt("Failed to open the file: \"{}\" ({})", filenames[i], loaded.errors[i].message()));
+
+            rslt.emplace_back(filenameEx(filenames[i]));
+
+            // The block owned by the file only is moved into the file.
+            if (loaded.size(i) == 0)
+                rslt.back() = String();
+            else if (loaded.offsets[i] == 0 && loaded.size(i) == loaded.blocks[loaded.blockIndices[i]].size())
+                rslt.back() = std::move(loaded.blocks[loaded.blockIndices[i]]);
+            else
+                rslt.back() = loaded.str(i);
+        }
+
+        return rslt;
+    }
+
+    String name_;
+    String* data_ = nullptr;
+    /// @brief The path of the disk file backs the data lazily.
+    String* backingPath_ = nullptr;
+    /// @brief Atomic since it's updated by the const accessors, which may be called by many threads.
+    mutable std::atomic<size_t> lastAccess_{ 0 };
+};
+
+class Dir
+{
+public:
+    Dir() = default;
+
+    ~Dir() { clear(); }
+
+    Dir(const Dir& other)
+    {
+        name_ = other.name_;
+
+        if (other.subFiles_)
+            subFiles_ = new Vec<File>(*other.subFiles_);
+
+        if (other.subDirs_)
+            subDirs_ = new Vec<Dir>(*other.subDirs_);
+    }
+
+    Dir(Dir&& other) noexcept
+    {
+        name_ = other.name_;
+
+        subFiles_ = other.subFiles_;
+        other.subFiles_ = nullptr;
+
+        subDirs_ = other.subDirs_;
+        other.subDirs_ = nullptr;
+    }
+
+    Dir& operator=(const Dir& other)
+    {
+        name_ = other.name_;
+
+        clear();
+
+        if (other.subFiles_)
+            subFiles_ = new Vec<File>(*other.subFiles_);
+
+        if (other.subDirs_)
+            subDirs_ = new Vec<Dir>(*other.subDirs_);
+
+        return *this;
+    }
+
+    /// @param isValidate If false, the name is not validated (for the trusted sources, e.g. the directory scans).
+    explicit Dir(const String& name, bool isValidate = true) { setName(name, isValidate); }
+
+    /// @brief Load the directory tree, the files of each directory are loaded by the File::fromDiskPaths().
+    /// @param executor The executor to read the files, nullptr means the ioExecutor().
+    static Dir fromDiskPath(const String& dirpath, Executor* executor = nullptr)
+    {
+        return fromDiskPath_(dirpath, true, executor);
+    }
+
+    String name() const { return name_; }
+
+    size_t size() const
+    {
+        size_t size = 0;
+
+        if (subFiles_)
+            for (const auto& var : *subFiles_)
+                size += var.size();
+
+        if (subDirs_)
+            for (const auto& var : *subDirs_)
+                size += var.size();
+
+        return size;
+    }
+
+    size_t fileCount(bool isRecursive = true) const
+    {
+        size_t cnt = 0;
+
+        if (subFiles_)
+            cnt += subFiles_->size();
+
+        if (isRecursive && subDirs_)
+            for (const auto& var : *subDirs_)
+                cnt += var.fileCount();
+
+        return cnt;
+    }
+
+    size_t dirCount(bool isRecursive = true) const
+    {
+        size_t cnt = 0;
+
+        if (subDirs_)
+            cnt += subDirs_->size();
+
+        if (isRecursive && subDirs_)
+            for (const auto& var : *subDirs_)
+                cnt += var.dirCount();
+
+        return cnt;
+    }
+
+    size_t count(bool isRecursive = true) const { return fileCount(isRecursive) + dirCount(isRecursive); }
+
+    bool empty() const { return size() == 0; }
+
+    /// @return The memory usage of this directory (include the node structure itself).
+    /// @param isRecursive If false, the sub directories just count their node structures.
+    MemoryUsage memoryUsage(bool isRecursive = true) const
+    {
+        MemoryUsage usage;
+
+        usage.nodes = sizeof(Dir);
+        _accountName(usage, name_);
+
+        if (subFiles_)
+        {
+            usage.nodes += sizeof(Vec<File>);
+            usage.slack += (subFiles_->capacity() - subFiles_->size()) * sizeof(File);
+
+            for (const auto& var : *subFiles_)
+                usage += var.memoryUsage();
+        }
+
+        if (subDirs_)
+        {
+            usage.nodes += sizeof(Vec<Dir>);
+            usage.slack += (subDirs_->capacity() - subDirs_->size()) * sizeof(Dir);
+
+            for (const auto& var : *subDirs_)
+            {
+                if (isRecursive)
+                    usage += var.memoryUsage(true);
+                else
+                    usage.nodes += sizeof(Dir);
+            }
+        }
+
+        return usage;
+    }
+
+    /// @brief Release the least recently used files data until the memory usage of the tree not exceed the budget.
+    /// @param spill Be called before the file data is released with the path of the file (relative to this directory),
+    /// can be used to spill the data to other storage.
+    /// @return The bytes released.
+    size_t enforceMemoryBudget(size_t budget, void (*spill)(const String& path, const File& file) = nullptr)
+    {
+        size_t total = memoryUsage().total();
+        if (total <= budget)
+            return 0;
+
+        Vec<std::pair<File*, String>> loadeds;
+        collectLoadedFiles_(loadeds, "", spill != nullptr);
+
+        std::sort(loadeds.begin(), loadeds.end(),
+                  [](const std::pair<File*, String>& lhs, const std::pair<File*, String>& rhs)
+                  { return lhs.first->lastAccess() < rhs.first->lastAccess(); });
+
+        size_t released = 0;
+        for (auto& var : loadeds)
+        {
+            if (total - released <= budget)
+                break;
+
+            if (spill)
+                spill(var.second, *var.first);
+
+            size_t before = var.first->memoryUsage().total();
+            var.first->releaseData();
+            released += before - var.first->memoryUsage().total();
+        }
+
+        return released;
+    }
+
+    bool hasFile(const String& name, bool isRecursive = false) const
+    {
+        if (hasFile_(name) != NOF_)
+            return true;
+
+        if (isRecursive && subDirs_)
+        {
+            for (const auto& var : *subDirs_)
+            {
+                if (var.hasFile(name, true))
+                    return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool hasDir(const String& name, bool isRecursive = false) const
+    {
+        if (hasDir_(name) != NOF_)
+            return true;
+
+        if (isRecursive && subDirs_)
+        {
+            for (const auto& var : *subDirs_)
+            {
+                if (var.hasDir(name, true))
+                    return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// @param isValidate If false, the name is not validated (for the trusted sources, e.g. the directory scans).
+    void setName(const String& name, bool isValidate = true)
+    {
+        if (isValidate && !isValidFilename(name))
+            throw Exception(_fmt("Invalid file name: \"{}\"", name));
+        name_ = name;
+    }
+
+    const Vec<File>& files() const { return *subFiles_; }
+
+    const Vec<Dir>& dirs() const { return *subDirs_; }
+
+    Vec<File>& files() { return *subFiles_; }
+
+    Vec<Dir>& dirs() { return *subDirs_; }
+
+    File& file(const String& name)
+    {
+        size_t pos = hasFile_(name);
+
+        if (pos == NOF_)
+        {
+            add(File(name));
+            return subFiles_->back();
+        }
+
+        return (*subFiles_)[pos];
+    }
+
+    Dir& dir(const String& name)
+    {
+        size_t pos = hasDir_(name);
+
+        if (pos == NOF_)
+        {
+            add(Dir(name));
+            return subDirs_->back();
+        }
+
+        return (*subDirs_)[pos];
+    }
+
+    void removeFile(const String& name)
+    {
+        size_t pos = hasFile_(name);
+        if (pos == NOF_)
+            return;
+
+        subFiles_->erase(subFiles_->begin() + pos);
+    }
+
+    void removeDir(const String& name)
+    {
+        size_t pos = hasDir_(name);
+        if (pos == NOF_)
+            return;
+
+        subDirs_->erase(subDirs_->begin() + pos);
+    }
+
+    void releaseAllFilesData()
+    {
+        if (subFiles_)
+            for (auto& var : *subFiles_)
+                var.releaseData();
+
+        if (subDirs_)
+            for (auto& var : *subDirs_)
+                var.releaseAllFilesData();
+    }
+
+    void clearFiles()
+    {
+        if (subFiles_)
+        {
+            delete subFiles_;
+            subFiles_ = nullptr;
+        }
+    }
+
+    void clearDirs()
+    {
+        if (subDirs_)
+        {
+            delete subDirs_;
+            subDirs_ = nullptr;
+        }
+    }
+
+    void clear()
+    {
+        clearFiles();
+        clearDirs();
+    }
+
+    void add(File& file, bool isOverwrite = false)
+    {
+        if (!subFiles_)
+            subFiles_ = new Vec<File>();
+
+        size_t pos = hasFile_(file.name());
+
+        if (pos != NOF_)
+        {
+            if (isOverwrite)
+                (*subFiles_)[pos] = std::move(file);
+            return;
+        }
+
+        subFiles_->emplace_back(std::move(file));
+    }
+
+    void add(Dir& dir, bool isOverwrite = false)
+    {
+        if (!subDirs_)
+            subDirs_ = new Vec<Dir>();
+
+        size_t pos = hasDir_(dir.name());
+
+        if (pos != NOF_)
+        {
+            if (isOverwrite)
+                (*subDirs_)[pos] = std::move(dir);
+            return;
+        }
+
+        subDirs_->emplace_back(std::move(dir));
+    }
+
+    void add(File&& file, bool isOverwrite = false) { add(file, isOverwrite); }
+
+    void add(Dir&& dir, bool isOverwrite = false) { add(dir, isOverwrite); }
+
+    void write(const String& path, bool isOverwrite = false,
+               std::ios_base::openmode openmode = std::ios_base::binary) const
+    {
+        String root = pathcat(path, name_);
+
+        createDirectory(root);
+
+        if (subFiles_)
+            for (const auto& var : *subFiles_)
+                var.write(root, isOverwrite, openmode);
+
+        if (subDirs_)
+            for (const auto& var : *subDirs_)
+                var.write(root, isOverwrite);
+    }
+
+    Dir copy() const { return Dir(*this); }
+
+    Dir& operator[](const String& name) { return dir(name); }
+
+    File& operator()(const String& name) { return file(name); }
+
+    Dir& operator<<(File& file)
+    {
+        add(file);
+        return *this;
+    }
+
+    Dir& operator<<(Dir& dir)
+    {
+        add(dir);
+        return *this;
+    }
+
+    Dir& operator<<(File&& file)
+    {
+        add(file);
+        return *this;
+    }
+
+    Dir& operator<<(Dir&& dir)
+    {
+        add(dir);
+        return *this;
+    }
+
+private:
+    static constexpr size_t NOF_ = size_t(-1);
+
+    static Dir fromDiskPath_(const String& dirpath, bool isValidate, Executor* executor)
+    {
+        Dir root(filenameEx(dirpath), isValidate);
+
+        // The names of the sub entries come from the directory scan, so they are not validated again.
+        auto dirs = getAllDirectorys(dirpath, false);
+        for (const auto& var : dirs)
+            root << Dir::fromDiskPath_(var, false, executor);
+
+        auto files = File::fromDiskPaths(getAllFiles(dirpath, false), executor);
+        for (auto& var : files)
+            root << var;
+
+        return root;
+    }
+
+    void collectLoadedFiles_(Vec<std::pair<File*, String>>& loadeds, const String& prefix, bool isWithPath)
+    {
+        if (subFiles_)
+        {
+            for (auto& var : *subFiles_)
+            {
+                if (var.isLazy() || var.size() == 0)
+                    continue;
+
+                if (isWithPath)
+                    loadeds.emplace_back(&var, prefix.empty() ? var.name() : pathcat(prefix, var.name()));
+                else
+                    loadeds.emplace_back(&var, String());
+            }
+        }
+
+        if (subDirs_)
+        {
+            for (auto& var : *subDirs_)
+            {
+                String _prefix = isWithPath ? (prefix.empty() ? var.name() : pathcat(prefix, var.name())) : String();
+                var.collectLoadedFiles_(loadeds, _prefix, isWithPath);
+            }
+        }
+    }
+
+    size_t hasFile_(const String& name) const
+    {
+        if (subFiles_)
+        {
+            for (size_t i = 0; i < subFiles_->size(); ++i)
+            {
+                if ((*subFiles_)[i].name() == name)
+                    return i;
+            }
+        }
+
+        return NOF_;
+    }
+
+    size_t hasDir_(const String& name) const
+    {
+        if (subDirs_)
+        {
+            for (size_t i = 0; i < subDirs_->size(); ++i)
+            {
+                if ((*subDirs_)[i].name() == name)
+                    return i;
+            }
+        }
+
+        return NOF_;
+    }
+
+    String name_;
+    Vec<File>* subFiles_ = nullptr;
+    Vec<Dir>* subDirs_ = nullptr;
+};
+
+/// @brief The cache of the filesystem metadata with the time to live, for the hot predicate calls.
+/// The cache is sharded by the path hash, so it can be used concurrently.
+/// @note The paths are the keys as is (not normalized), use the same form of the path for a same entity.
+/// @note The errors are not cached.
+class StatCache
+{
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    /// @param ttl The time to live of the cached entries.
+    /// @param isNegativeCache If true, the not exists results are also cached.
+    /// @param shardCount The count of the shards, more shards less lock contention.
+    explicit StatCache(Duration ttl = std::chrono::seconds(1), bool isNegativeCache = true, size_t shardCount = 16) :
+        ttl_(ttl), isNegativeCache_(isNegativeCache), shardCount_(shardCount == 0 ? 1 : shardCount),
+        shards_(new Shard_[shardCount_])
+    {}
+
+    ~StatCache() { unwatch(); }
+
+    StatCache(const StatCache&) = delete;
+
+    StatCache& operator=(const StatCache&) = delete;
+
+    /// @brief Same as the status() function, but return the cached one if it is not expired.
+    FileStatus status(const String& path) { return get_(path, true); }
+
+    /// @brief Same as the lstatus() function, but return the cached one if it is not expired.
+    FileStatus lstatus(const String& path) { return get_(path, false); }
+
+    bool isExists(const String& path) { return status(path).exists(); }
+
+    bool isFile(const String& path) { return status(path).isFile(); }
+
+    bool isDirectory(const String& path) { return status(path).isDirectory(); }
+
+    bool isSymlink(const String& path) { return lstatus(path).isSymlink(); }
+
+    /// @brief Remove the cached entry of the path.
+    void invalidate(const String& path)
+    {
+        Shard_& shard = shard_(path);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.erase(path);
+    }
+
+    /// @brief Remove the cached entries of the path and the paths under it.
+    void invalidateTree(const String& path)
+    {
+        bool isDirPath = !path.empty() && _isSeparator(path.back());
+
+        for (size_t i = 0; i < shardCount_; ++i)
+        {
+            std::lock_guard<std::mutex> lock(shards_[i].mutex);
+
+            for (auto it = shards_[i].entries.begin(); it != shards_[i].entries.end();)
+            {
+                const String& key = it->first;
+                bool isUnder = key.size() > path.size() && key.compare(0, path.size(), path) == 0 &&
+                               (isDirPath || _isSeparator(key[path.size()]));
+
+                if (isUnder || key == path)
+                    it = shards_[i].entries.erase(it);
+                else
+                    ++it;
+            }
+        }
+    }
+
+    /// @brief Remove all the cached entries.
+    void clear()
+    {
+        for (size_t i = 0; i < shardCount_; ++i)
+        {
+            std::lock_guard<std::mutex> lock(shards_[i].mutex);
+            shards_[i].entries.clear();
+        }
+    }
+
+    /// @return The count of the cached paths (include the expired ones not removed yet).
+    size_t size() const
+    {
+        size_t cnt = 0;
+
+        for (size_t i = 0; i < shardCount_; ++i)
+        {
+            std::lock_guard<std::mutex> lock(shards_[i].mutex);
+            cnt += shards_[i].entries.size();
+        }
+
+        return cnt;
+    }
+
+    Duration ttl() const { return ttl_; }
+
+    /// @note Just affects the entries cached after.
+    void setTtl(Duration ttl) { ttl_ = ttl; }
+
+    /// @brief Invalidate the cached entries when the entries of the directory are changed,
+    /// the watching is performed in a background thread until the unwatch() is called.
+    /// @param isRecursive If true, the existing sub directories are also watched (the new ones are not).
+    /// @return If the watching is not supported (just supported in Linux) or failed, return false.
+    /// @note The invalidated keys are the paths joined by the directory and the entry name,
+    /// and the keys under a moved or deleted directory (see the invalidateTree()).
+    bool watch(const String& dir, bool isRecursive = false)
+    {
+        std::lock_guard<std::mutex> lock(watchMutex_);
+
+        if (watcher_ < 0)
+        {
+            watcher_ = _watcherOpen();
+            if (watcher_ < 0)
+                return false;
+
+            isStop_ = false;
+            watchThread_ = std::thread(&StatCache::watchLoop_, this);
+        }
+
+        Strings dirs(1, dir);
+        if (isRecursive)
+        {
+            std::error_code ec;
+            Strings subDirs = getAllDirectorys(dir, true, nullptr, ec);
+            dirs.insert(dirs.end(), subDirs.begin(), subDirs.end());
+        }
+
+        for (size_t i = 0; i < dirs.size(); ++i)
+        {
+            int wd = _watcherAdd(watcher_, dirs[i]);
+            if (wd < 0)
+            {
+                if (i == 0)
+                    return false;
+                continue;
+            }
+
+            std::lock_guard<std::mutex> dirsLock(watchDirsMutex_);
+            watchDirs_[wd] = dirs[i];
+        }
+
+        return true;
+    }
+
+    /// @brief Stop all the watching.
+    void unwatch()
+    {
+        std::lock_guard<std::mutex> lock(watchMutex_);
+
+        if (watcher_ < 0)
+            return;
+
+        isStop_ = true;
+        watchThread_.join();
+
+        _watcherClose(watcher_);
+        watcher_ = -1;
+
+        std::lock_guard<std::mutex> dirsLock(watchDirsMutex_);
+        watchDirs_.clear();
+    }
+
+private:
+    struct Entry_
+    {
+        FileStatus status;
+        FileStatus lstatus;
+        std::chrono::steady_clock::time_point statusExpiry;
+        std::chrono::steady_clock::time_point lstatusExpiry;
+    };
+
+    struct Shard_
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<String, Entry_> entries;
+    };
+
+    Shard_& shard_(const String& path) { return shards_[std::hash<String>()(path) % shardCount_]; }
+
+    FileStatus get_(const String& path, bool isFollow)
+    {
+        Shard_& shard = shard_(path);
+        auto now = std::chrono::steady_clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            auto it = shard.entries.find(path);
+            if (it != shard.entries.end())
+            {
+                if (isFollow && now < it->second.statusExpiry)
+                    return it->second.status;
+                if (!isFollow && now < it->second.lstatusExpiry)
+                    return it->second.lstatus;
+            }
+        }
+
+        // The stat is performed without the lock, the concurrent misses of a same path may stat repeatedly.
+        FileStatus rslt = isFollow ? wfs::status(path) : wfs::lstatus(path);
+
+        if (rslt.exists() || isNegativeCache_)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            Entry_& entry = shard.entries[path];
+            if (isFollow)
+            {
+                entry.status = rslt;
+                entry.statusExpiry = now + ttl_.load();
+            }
+            else
+            {
+                entry.lstatus = rslt;
+                entry.lstatusExpiry = now + ttl_.load();
+            }
+        }
+
+        return rslt;
+    }
+
+    void watchLoop_()
+    {
+        while (!isStop_)
+        {
+            for (const auto& event : _watcherRead(watcher_, 100))
+            {
+                // Some changes are lost.
+                if (event.wd < 0)
+                {
+                    clear();
+                    continue;
+                }
+
+                String dir;
+                {
+                    std::lock_guard<std::mutex> lock(watchDirsMutex_);
+                    auto it = watchDirs_.find(event.wd);
+                    if (it == watchDirs_.end())
+                        continue;
+                    dir = it->second;
+
+                    // The watched directory itself is moved or deleted, so its path is not valid anymore.
+                    if (event.isTree && event.name.empty())
+                        watchDirs_.erase(it);
+                }
+
+                // The cached paths under a moved or deleted directory are stale too.
+                String path = event.name.empty() ? dir : pathcat(dir, event.name);
+                invalidate(dir);
+                if (event.isTree)
+                    invalidateTree(path);
+                else if (!event.name.empty())
+                    invalidate(path);
+            }
+        }
+    }
+
+    std::atomic<Duration> ttl_;
+    bool isNegativeCache_;
+    size_t shardCount_;
+    std::unique_ptr<Shard_[]> shards_;
+
+    std::mutex watchMutex_;
+    std::mutex watchDirsMutex_;
+    std::thread watchThread_;
+    std::atomic<bool> isStop_{ true };
+    int watcher_ = -1;
+    std::unordered_map<int, String> watchDirs_;
+};
+
+/// @brief The cache of the symlink resolution, for the canonicalization of the paths in the deep symlink trees.
+/// The resolved entries are cached per directory (keyed by the device and inode of the directory),
+/// and the entries of a directory are dropped when the ctime of the directory is changed
+/// (create, delete, rename or relink an entry in the directory changes the ctime of the directory).
+/// Each directory is validated (one lstat) at most once per the ttl, so resolving a cached path costs no syscall
+/// within the ttl, and the least recently used directories are evicted beyond the max count.
+/// @note The changes within the ttl, or within the ctime granularity of the filesystem, may be not detected.
+class RealpathCache
+{
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    /// @brief The cache shared by the whole process.
+    static RealpathCache& shared()
+    {
+        static RealpathCache cache;
+        return cache;
+    }
+
+    /// @param ttl The time to trust a validated directory, zero means validating the directories once per call
+    /// (the paths sharing the prefixes should be resolved by the canonicals() together then).
+    /// @param maxDirCount The max count of the cached directories.
+    explicit RealpathCache(Duration ttl = std::chrono::seconds(1), size_t maxDirCount = 65536) :
+        ttl_(ttl), maxDirCount_(maxDirCount == 0 ? 1 : maxDirCount)
+    {}
+
+    RealpathCache(const RealpathCache&) = delete;
+
+    RealpathCache& operator=(const RealpathCache&) = delete;
+
+    /// @brief Get the absolute path without the symlinks, "." and "..", the path must exists.
+    String canonical(const String& path)
+    {
+        std::error_code ec;
+        String rslt = canonical(path, ec);
+
+        if (ec)
+            throw Exception(_fmt("Failed to resolve the path: \"{}\" ({})", path, ec.message()));
+
+        return rslt;
+    }
+
+    String canonical(const String& path, std::error_code& ec)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        ++tick_;
+        Batch_ batch;
+        return resolve_(path, batch, ec);
+    }
+
+    /// @brief Same as the canonical() for each path, the shared directories are validated once.
+    Strings canonicals(const Strings& paths)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        ++tick_;
+        Batch_ batch;
+        Strings rslt(paths.size());
+
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            std::error_code ec;
+            rslt[i] = resolve_(paths[i], batch, ec);
+
+            if (ec)
+                throw Exception(_fmt("Failed to resolve the path: \"{}\" ({})", paths[i], ec.message()));
+        }
+
+        return rslt;
+    }
+
+    /// @note The results of the failed paths are empty, and the ec is the first error.
+    Strings canonicals(const Strings& paths, std::error_code& ec)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        ec.clear();
+        ++tick_;
+        Batch_ batch;
+        Strings rslt(paths.size());
+
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            std::error_code _ec;
+            rslt[i] = resolve_(paths[i], batch, _ec);
+
+            if (_ec && !ec)
+                ec = _ec;
+        }
+
+        return rslt;
+    }
+
+    /// @return The count of the cached entries.
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        size_t cnt = 0;
+        for (const auto& var : dirs_)
+            cnt += var.second.entries.size();
+
+        return cnt;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirs_.clear();
+        paths_.clear();
+    }
+
+    Duration ttl() const { return ttl_; }
+
+    /// @note Just affects the directories validated after.
+    void setTtl(Duration ttl) { ttl_ = ttl; }
+
+private:
+    static constexpr size_t MAX_SYMLINK_COUNT_ = 40;
+
+    struct Key_
+    {
+        uint64_t device;
+        uint64_t inode;
+
+        bool operator==(const Key_& other) const { return device == other.device && inode == other.inode; }
+    };
+
+    struct KeyHash_
+    {
+        size_t operator()(const Key_& key) const
+        {
+            return static_cast<size_t>(key.inode * 0x9E3779B97F4A7C15ull ^ key.device);
+        }
+    };
+
+    struct Entry_
+    {
+        FileType type;
+        Key_ key;
+        String target;
+    };
+
+    struct Dir_
+    {
+        int64_t ctime = -1;
+        /// @brief The tick of the call used the directory last, for the eviction.
+        uint64_t lastUse = 0;
+        std::unordered_map<String, Entry_> entries;
+    };
+
+    /// @brief The directory of a resolved path, trusted until the expiry.
+    struct Path_
+    {
+        Key_ key;
+        std::chrono::steady_clock::time_point expiry;
+    };
+
+    /// @brief The validated directories in a call, by the resolved paths.
+    using Batch_ = std::unordered_map<String, Key_>;
 
-    static File fromDiskPath(const String& filename)
+    /// @brief Validate the cached entries of the directory by the status of the directory.
+    Dir_& validate_(const String& dir, const Key_& key, int64_t ctime, Batch_& batch)
     {
-        IFStream ifs(filename, std::ios_base::binary);
+        Dir_& rslt = dirs_[key];
+        if (rslt.ctime != ctime)
+        {
+            rslt.entries.clear();
+            rslt.ctime = ctime;
+        }
+        rslt.lastUse = tick_;
 
-        if (!ifs.is_open())
-            throw Exception(_fmt("Failed to open the file: \"{}\"", filename));
+        Path_& path = paths_[dir];
+        path.key = key;
+        path.expiry = std::chrono::steady_clock::now() + ttl_.load();
 
-        File file(filenameEx(filename));
-        file << ifs;
+        batch[dir] = key;
 
-        ifs.close();
+        // The directories used in this call are not evicted, so the rslt is still valid.
+        if (dirs_.size() > maxDirCount_)
+            evict_();
 
-        return file;
+        return rslt;
     }
 
-    File copy() const { return File(*this); }
+    /// @brief Evict the least recently used quarter of the directories, except the ones used in this call.
+    void evict_()
+    {
+        Vec<std::pair<uint64_t, Key_>> uses;
+        for (const auto& var : dirs_)
+        {
+            if (var.second.lastUse < tick_)
+                uses.emplace_back(var.second.lastUse, var.first);
+        }
 
-    String name() const { return name_; }
+        size_t count = std::min(uses.size(), dirs_.size() - maxDirCount_ + maxDirCount_ / 4);
+        auto isEarlier = [](const std::pair<uint64_t, Key_>& a, const std::pair<uint64_t, Key_>& b)
+        {
+            return a.first < b.first;
+        };
+        if (count < uses.size())
+            std::nth_element(uses.begin(), uses.begin() + static_cast<ptrdiff_t>(count), uses.end(), isEarlier);
 
-    String data() const { return data_ ? *data_ : ""; }
+        for (size_t i = 0; i < count; ++i)
+            dirs_.erase(uses[i].second);
 
-    size_t size() const { return data_ ? data_->size() : 0; }
+        for (auto it = paths_.begin(); it != paths_.end();)
+        {
+            if (dirs_.count(it->second.key) == 0)
+                it = paths_.erase(it);
+            else
+                ++it;
+        }
+    }
 
-    bool empty() const { return size() == 0; }
+    /// @return The validated directory of the resolved path, nullptr if failed.
+    Dir_* dir_(const String& dir, Batch_& batch, std::error_code& ec)
+    {
+        auto it = batch.find(dir);
+        if (it != batch.end())
+            return &dirs_[it->second];
 
-    void setName(const String& name) { name_ = name; }
+        // The directory validated within the ttl is trusted without the lstat.
+        auto pathIt = paths_.find(dir);
+        if (pathIt != paths_.end() && std::chrono::steady_clock::now() < pathIt->second.expiry)
+        {
+            auto dirIt = dirs_.find(pathIt->second.key);
+            if (dirIt != dirs_.end())
+            {
+                dirIt->second.lastUse = tick_;
+                batch[dir] = pathIt->second.key;
+                return &dirIt->second;
+            }
+        }
 
-    void releaseData()
-    {
-        if (data_)
+        FileStatus stat = wfs::lstatus(dir, ec);
+        if (ec)
+            return nullptr;
+
+        if (!stat.isDirectory())
         {
-            delete data_;
-            data_ = nullptr;
+            ec = std::make_error_code(stat.exists() ? std::errc::not_a_directory : std::errc::no_such_file_or_directory);
+            return nullptr;
         }
+
+        return &validate_(dir, { stat.device, stat.inode }, stat.ctime, batch);
     }
 
-    void write(OStream& os) const
+    /// @brief Push the names of the path to the stack of the pending names (the back is the next one).
+    static void pushNames_(Strings& names, PathView path)
     {
-        if (data_)
-            os << *data_;
+        size_t begin = names.size();
+        for (PathView name : path)
+            names.push_back(name.str());
+
+        std::reverse(names.begin() + static_cast<ptrdiff_t>(begin), names.end());
     }
 
-    void write(const String& path, bool isOverwrite = false,
-               std::ios_base::openmode openmode = std::ios_base::binary) const
+    String resolve_(const String& path, Batch_& batch, std::error_code& ec)
     {
-        String _path = path + PREFERRED_PATH_SEPARATOR + name_;
+        ec.clear();
 
-        if (!isOverwrite && isFile(_path))
-            return;
+        String _path = absolute(path);
+        String rslt = PathView(_path).rootPath().str();
+        size_t rootSize = rslt.size();
+        size_t symlinkCount = 0;
 
-        std::ofstream ofs(_path.data(), openmode);
+        Strings names;
+        pushNames_(names, _path);
 
-        if (!ofs.is_open())
-            throw Exception(_fmt("Failed to open the file: \"{}\"", _path));
+        while (!names.empty())
+        {
+            String name = std::move(names.back());
+            names.pop_back();
 
-        write(ofs);
+            if (name == ".")
+                continue;
 
-        ofs.close();
-    }
+            if (name == "..")
+            {
+                size_t pos = rslt.size();
+                while (pos > rootSize && !_isSeparator(rslt[pos - 1]))
+                    --pos;
+                rslt.resize(pos > rootSize ? pos - 1 : rootSize);
+                continue;
+            }
 
-    File& operator=(const String& data)
-    {
-        releaseData();
-        data_ = new String(data);
-        return *this;
-    }
+            Dir_* dir = dir_(rslt, batch, ec);
+            if (dir == nullptr)
+                return String();
 
-    template <typename T>
-    File& operator=(const Vec<T>& data)
-    {
-        releaseData();
+            String child = rslt;
+            if (!child.empty() && !_isSeparator(child.back()))
+                child += PREFERRED_PATH_SEPARATOR;
+            child += name;
 
-        data_ = new String;
-        data_->reserve(data_->size() + data.size());
+            auto it = dir->entries.find(name);
+            if (it == dir->entries.end())
+            {
+                FileStatus stat = wfs::lstatus(child, ec);
+                if (ec)
+                    return String();
+
+                Entry_ entry = { stat.type, { stat.device, stat.inode }, String() };
+                if (stat.isSymlink())
+                {
+                    entry.target = symlinkTarget(child, ec);
+                    if (ec)
+                        return String();
+                }
+
+                it = dir->entries.emplace(name, std::move(entry)).first;
+
+                // The status is just got, so the directory is validated in this call.
+                if (stat.isDirectory())
+                    validate_(child, it->second.key, stat.ctime, batch);
+            }
 
-        for (const auto& var : data)
-            data_->push_back(var);
+            const Entry_& entry = it->second;
 
-        return *this;
-    }
+            if (entry.type == FileType::NotFound)
+            {
+                ec = std::make_error_code(std::errc::no_such_file_or_directory);
+                return String();
+            }
 
-    File& operator<<(const File& other)
-    {
-        if (!data_)
-            data_ = new String;
-        data_->append(other.data());
+            if (entry.type == FileType::Symlink)
+            {
+                if (++symlinkCount > MAX_SYMLINK_COUNT_)
+                {
+                    ec = std::make_error_code(std::errc::too_many_symbolic_link_levels);
+                    return String();
+                }
+
+                PathView target(entry.target);
+                pushNames_(names, target);
+
+                if (target.isAbsolute())
+                {
+                    rslt = target.rootPath().str();
+                    rootSize = rslt.size();
+                }
+
+                continue;
+            }
 
-        return *this;
+            if (!names.empty() && entry.type != FileType::Directory)
+            {
+                ec = std::make_error_code(std::errc::not_a_directory);
+                return String();
+            }
+
+            rslt.swap(child);
+        }
+
+        return rslt;
     }
 
-    File& operator<<(IStream& is)
-    {
-        is.seekg(0, std::ios_base::end);
-        size_t size = is.tellg();
-        is.seekg(0, std::ios_base::beg);
+    std::atomic<Duration> ttl_;
+    size_t maxDirCount_;
 
-        if (!data_)
-            data_ = new String();
-        data_->reserve(data_->size() + size);
+    mutable std::mutex mutex_;
+    std::unordered_map<Key_, Dir_, KeyHash_> dirs_;
+    std::unordered_map<String, Path_> paths_;
+    uint64_t tick_ = 0;
+};
 
-        char buffer[_BUFFER_SIZE] = {};
-        while (is.read(buffer, _BUFFER_SIZE))
-            data_->append(String(buffer, is.gcount()));
+/// @brief The file type detection by the magic bytes.
+/// The signatures are compiled into a trie of the bytes (the "??" of the pattern is a wildcard edge),
+/// so a detection reads the head of the file once (at most the probeSize() bytes by a pread, see the readFileHead())
+/// and walks the trie once, instead of reading the whole file or trusting the extension.
+/// The signature with the most exact bytes wins, e.g. the "webp" (RIFF????WEBP) wins the "riff" (RIFF).
+/// @note The types are the names given by the add() (the common extensions without the dot for the builtin()).
+// @example
+// FileTypeDetector::builtin().detectFile("path/to/image") -> "png"
+// FileTypeDetector::builtin().filterFiles(getAllFiles("dir"), { "jpeg", "png" }) -> The JPEG and PNG files.
+// walkFiles("dir", true, [&](const String& path) { ... }) with FileTypeDetector::builtin().filter({ "pdf" }).
+class FileTypeDetector
+{
+public:
+    static constexpr size_t npos = size_t(-1);
 
-        data_->append(String(buffer, is.gcount()));
+    FileTypeDetector() : nodes_(1) {}
 
-        return *this;
+    /// @return The detector with the signatures of the common types
+    /// (images, audio, video, archives, documents, fonts and executables).
+    static const FileTypeDetector& builtin()
+    {
+        static const FileTypeDetector detector = builtin_();
+        return detector;
     }
 
-    File& operator<<(const String& data)
+    /// @brief Add the signature of the type, the first type is kept if the same signature is added again.
+    /// @param pattern The hex bytes of the magic, the "??" matches any byte and the spaces are ignored,
+    /// e.g. "52 49 46 46 ?? ?? ?? ?? 57 45 42 50".
+    /// @param offset The offset of the magic from the begin of the file.
+    /// @note Throw if the pattern is invalid (or matches the empty data).
+    void add(const String& type, const String& pattern, size_t offset = 0)
     {
-        if (!data_)
-            data_ = new String();
-        data_->append(data);
+        size_t node = 0;
+        for (size_t i = 0; i < offset; ++i)
+            node = any_(node);
 
-        return *this;
-    }
+        size_t depth = offset;
+        size_t exactCount = 0;
 
-    template <typename T>
-    File& operator<<(const Vec<T>& data)
-    {
-        size_t size = data.size();
+        for (size_t i = 0; i < pattern.size(); ++i)
+        {
+            if (pattern[i] == ' ')
+                continue;
 
-        if (!data_)
-            data_ = new String;
-        data_->reserve(data_->size() + size);
+            if (i + 1 >= pattern.size())
+                throw Exception(_fmt("Invalid signature pattern: \"{}\"", pattern));
 
-        for (const auto& var : data)
-            data_->push_back(var);
+            if (pattern[i] == '?' && pattern[i + 1] == '?')
+            {
+                node = any_(node);
+            }
+            else
+            {
+                int high = hexDigit_(pattern[i]);
+                int low = hexDigit_(pattern[i + 1]);
+                if (high < 0 || low < 0)
+                    throw Exception(_fmt("Invalid signature pattern: \"{}\"", pattern));
 
-        return *this;
+                node = child_(node, static_cast<unsigned char>(high * 16 + low), true);
+                ++exactCount;
+            }
+
+            ++i;
+            ++depth;
+        }
+
+        if (exactCount == 0)
+            throw Exception(_fmt("Invalid signature pattern: \"{}\"", pattern));
+
+        if (nodes_[node].type == npos)
+        {
+            auto it = std::find(types_.begin(), types_.end(), type);
+            nodes_[node].type = static_cast<size_t>(it - types_.begin());
+            if (it == types_.end())
+                types_.push_back(type);
+        }
+
+        probeSize_ = std::max(probeSize_, depth);
     }
 
-    const File& operator>>(OStream& os) const
+    /// @return The count of the bytes needed from the head of the file (the end of the farthest signature).
+    size_t probeSize() const { return probeSize_; }
+
+    /// @return The types of the signatures added (without the duplicates).
+    const Strings& types() const { return types_; }
+
+    /// @return The type of the data (the head of the file), empty if unknown.
+    String detect(const char* data, size_t size) const
     {
-        write(os);
-        return *this;
+        size_t type = match_(data, size);
+        return type != npos ? types_[type] : String();
     }
 
-private:
-    String name_;
-    String* data_ = nullptr;
-};
-
-class Dir
-{
-public:
-    Dir() = default;
+    String detect(const String& head) const { return detect(head.data(), head.size()); }
 
-    ~Dir() { clear(); }
+    /// @return The type of the file, empty if unknown (include the file failed to read).
+    String detectFile(const String& path) const
+    {
+        std::error_code ec;
+        return detect(readFileHead(path, probeSize_, ec));
+    }
 
-    Dir(const Dir& other)
+    /// @brief The batch version of the detectFile(), the heads of the files are read by the loadFileRanges()
+    /// (by the io_uring in Linux if available), and detected in parallel.
+    /// @param executor The executor to read the heads, nullptr means the ioExecutor().
+    Strings detectFiles(const Strings& paths, Executor* executor = nullptr) const
     {
-        name_ = other.name_;
+        Vec<size_t> matched = matchFiles_(paths, executor);
 
-        if (other.subFiles_)
-            subFiles_ = new Vec<File>(*other.subFiles_);
+        Strings rslt(paths.size());
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            if (matched[i] != npos)
+                rslt[i] = types_[matched[i]];
+        }
 
-        if (other.subDirs_)
-            subDirs_ = new Vec<Dir>(*other.subDirs_);
+        return rslt;
     }
 
-    Dir(Dir&& other) noexcept
+    /// @return The files of the types (keep the order), detected by the detectFiles().
+    Strings filterFiles(const Strings& paths, const Strings& types, Executor* executor = nullptr) const
     {
-        name_ = other.name_;
+        Vec<char> isWanted = wanted_(types);
+        Vec<size_t> matched = matchFiles_(paths, executor);
 
-        subFiles_ = other.subFiles_;
-        other.subFiles_ = nullptr;
+        Strings rslt;
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            if (matched[i] != npos && isWanted[matched[i]])
+                rslt.push_back(paths[i]);
+        }
 
-        subDirs_ = other.subDirs_;
-        other.subDirs_ = nullptr;
+        return rslt;
     }
 
-    Dir& operator=(const Dir& other)
+    /// @return The predicate of the files of the types, as the filter of the traversal
+    /// (e.g. the walkFiles() and the Pipeline::filter()).
+    /// @note The detector must be alive while the predicate is used.
+    std::function<bool(const String&)> filter(const Strings& types) const
     {
-        name_ = other.name_;
+        Vec<char> isWanted = wanted_(types);
 
-        clear();
+        return [this, isWanted](const String& path) -> bool
+        {
+            std::error_code ec;
+            String head = readFileHead(path, probeSize_, ec);
 
-        if (other.subFiles_)
-            subFiles_ = new Vec<File>(*other.subFiles_);
+            size_t type = match_(head.data(), head.size());
+            return type != npos && isWanted[type];
+        };
+    }
 
-        if (other.subDirs_)
-            subDirs_ = new Vec<Dir>(*other.subDirs_);
+private:
+    struct Node_
+    {
+        // The exact children (sorted by the byte) and the wildcard child.
+        Vec<std::pair<unsigned char, size_t>> children;
+        size_t any = npos;
+        size_t type = npos;
+    };
 
-        return *this;
+    static FileTypeDetector builtin_()
+    {
+        static const char* const signatures[][3] = {
+            { "png",    "89 50 4E 47 0D 0A 1A 0A",                          "0" },
+            { "jpeg",   "FF D8 FF",                                         "0" },
+            { "gif",    "47 49 46 38 37 61",                                "0" },
+            { "gif",    "47 49 46 38 39 61",                                "0" },
+            { "bmp",    "42 4D ?? ?? ?? ?? 00 00 00 00",                    "0" },
+            { "tiff",   "49 49 2A 00",                                      "0" },
+            { "tiff",   "4D 4D 00 2A",                                      "0" },
+            { "ico",    "00 00 01 00",                                      "0" },
+            { "psd",    "38 42 50 53",                                      "0" },
+            { "webp",   "52 49 46 46 ?? ?? ?? ?? 57 45 42 50",              "0" },
+            { "wav",    "52 49 46 46 ?? ?? ?? ?? 57 41 56 45",              "0" },
+            { "avi",    "52 49 46 46 ?? ?? ?? ?? 41 56 49 20",              "0" },
+            { "heic",   "66 74 79 70 68 65 69 63",                          "4" },
+            { "avif",   "66 74 79 70 61 76 69 66",                          "4" },
+            { "mp4",    "66 74 79 70",                                      "4" },
+            { "mkv",    "1A 45 DF A3",                                      "0" },
+            { "mp3",    "49 44 33",                                         "0" },
+            { "mp3",    "FF FB",                                            "0" },
+            { "flac",   "66 4C 61 43",                                      "0" },
+            { "ogg",    "4F 67 67 53",                                      "0" },
+            { "pdf",    "25 50 44 46 2D",                                   "0" },
+            { "rtf",    "7B 5C 72 74 66 31",                                "0" },
+            { "xml",    "3C 3F 78 6D 6C 20",                                "0" },
+            { "ole",    "D0 CF 11 E0 A1 B1 1A E1",                          "0" },
+            { "sqlite", "53 51 4C 69 74 65 20 66 6F 72 6D 61 74 20 33 00",  "0" },
+            { "zip",    "50 4B 03 04",                                      "0" },
+            { "zip",    "50 4B 05 06",                                      "0" },
+            { "zip",    "50 4B 07 08",                                      "0" },
+            { "gzip",   "1F 8B 08",                                         "0" },
+            { "bzip2",  "42 5A 68",                                         "0" },
+            { "xz",     "FD 37 7A 58 5A 00",                                "0" },
+            { "zstd",   "28 B5 2F FD",                                      "0" },
+            { "lz4",    "04 22 4D 18",                                      "0" },
+            { "7z",     "37 7A BC AF 27 1C",                                "0" },
+            { "rar",    "52 61 72 21 1A 07",                                "0" },
+            { "tar",    "75 73 74 61 72",                                   "257" },
+            { "ar",     "21 3C 61 72 63 68 3E 0A",                          "0" },
+            { "woff",   "77 4F 46 46",                                      "0" },
+            { "woff2",  "77 4F 46 32",                                      "0" },
+            { "otf",    "4F 54 54 4F",                                      "0" },
+            { "ttf",    "00 01 00 00 00",                                   "0" },
+            { "elf",    "7F 45 4C 46",                                      "0" },
+            { "exe",    "4D 5A",                                            "0" },
+            { "macho",  "FE ED FA CE",                                      "0" },
+            { "macho",  "FE ED FA CF",                                      "0" },
+            { "macho",  "CE FA ED FE",                                      "0" },
+            { "macho",  "CF FA ED FE",                                      "0" },
+            { "wasm",   "00 61 73 6D",                                      "0" },
+            { "script", "23 21",                                            "0" }
+        };
+
+        FileTypeDetector detector;
+        for (const auto& var : signatures)
+            detector.add(var[0], var[1], static_cast<size_t>(std::stoul(var[2])));
+
+        return detector;
+    }
+
+    static int hexDigit_(char ch)
+    {
+        if (ch >= '0' && ch <= '9')
+            return ch - '0';
+        if (ch >= 'A' && ch <= 'F')
+            return ch - 'A' + 10;
+        if (ch >= 'a' && ch <= 'f')
+            return ch - 'a' + 10;
+
+        return -1;
     }
 
-    explicit Dir(const String& name) { setName(name); }
+    size_t child_(size_t node, unsigned char byte) const
+    {
+        const auto& children = nodes_[node].children;
+        auto it = lowerBound_(children, byte);
+
+        return it != children.end() && it->first == byte ? it->second : npos;
+    }
 
-    static Dir fromDiskPath(const String& dirpath)
+    size_t child_(size_t node, unsigned char byte, bool isCreate)
     {
-        Dir root(filenameEx(dirpath));
+        size_t rslt = child_(node, byte);
+        if (rslt != npos || !isCreate)
+            return rslt;
 
-        auto dirs = getAllDirectorys(dirpath, false);
-        for (const auto& var : dirs)
-            root << Dir::fromDiskPath(var);
+        rslt = nodes_.size();
+        nodes_.push_back(Node_());
 
-        auto files = getAllFiles(dirpath, false);
-        for (const auto& var : files)
-            root << File::fromDiskPath(var);
+        auto& children = nodes_[node].children;
+        children.insert(lowerBound_(children, byte), std::make_pair(byte, rslt));
 
-        return root;
+        return rslt;
     }
 
-    String name() const { return name_; }
-
-    size_t size() const
+    size_t any_(size_t node)
     {
-        size_t size = 0;
-
-        if (subFiles_)
-            for (const auto& var : *subFiles_)
-                size += var.size();
+        if (nodes_[node].any == npos)
+        {
+            size_t rslt = nodes_.size();
+            nodes_.push_back(Node_());
+            nodes_[node].any = rslt;
+        }
 
-        if (subDirs_)
-            for (const auto& var : *subDirs_)
-                size += var.size();
+        return nodes_[node].any;
+    }
 
-        return size;
+    static Vec<std::pair<unsigned char, size_t>>::const_iterator
+    lowerBound_(const Vec<std::pair<unsigned char, size_t>>& children, unsigned char byte)
+    {
+        return std::lower_bound(children.begin(), children.end(), byte,
+                                [](const std::pair<unsigned char, size_t>& child, unsigned char key)
+                                { return child.first < key; });
     }
 
-    size_t fileCount(bool isRecursive = true) const
+    /// @return The index of the type matched, npos if unknown.
+    size_t match_(const char* data, size_t size) const
     {
-        size_t cnt = 0;
+        // Depth-first by the exact and the wildcard children,
+        // the signature with the most exact bytes wins (the longer one if tie).
+        struct Frame_
+        {
+            size_t node;
+            size_t depth;
+            size_t exactCount;
+        };
 
-        if (subFiles_)
-            cnt += subFiles_->size();
+        Vec<Frame_> stack;
+        stack.reserve(8);
+        stack.push_back({ 0, 0, 0 });
 
-        if (isRecursive && subDirs_)
-            for (const auto& var : *subDirs_)
-                cnt += var.fileCount();
+        size_t rslt = npos;
+        size_t bestExactCount = 0;
+        size_t bestDepth = 0;
 
-        return cnt;
+        while (!stack.empty())
+        {
+            Frame_ frame = stack.back();
+            stack.pop_back();
+
+            const Node_& node = nodes_[frame.node];
+            if (node.type != npos && (frame.exactCount > bestExactCount ||
+                                      (frame.exactCount == bestExactCount && frame.depth > bestDepth)))
+            {
+                rslt = node.type;
+                bestExactCount = frame.exactCount;
+                bestDepth = frame.depth;
+            }
+
+            if (frame.depth >= size)
+                continue;
+
+            if (node.any != npos)
+                stack.push_back({ node.any, frame.depth + 1, frame.exactCount });
+
+            size_t child = child_(frame.node, static_cast<unsigned char>(data[frame.depth]));
+            if (child != npos)
+                stack.push_back({ child, frame.depth + 1, frame.exactCount + 1 });
+        }
+
+        return rslt;
     }
 
-    size_t dirCount(bool isRecursive = true) const
+    Vec<size_t> matchFiles_(const Strings& paths, Executor* executor) const
     {
-        size_t cnt = 0;
+        LoadedFiles heads = loadFileRanges(paths, 0, probeSize_, executor);
 
-        if (subDirs_)
-            cnt += subDirs_->size();
+        Vec<size_t> rslt(paths.size(), size_t(npos));
+        parallelFor(paths.size(), [&](size_t i) { rslt[i] = match_(heads.data(i), heads.size(i)); });
 
-        if (isRecursive && subDirs_)
-            for (const auto& var : *subDirs_)
-                cnt += var.dirCount();
+        return rslt;
+    }
 
-        return cnt;
+    Vec<char> wanted_(const Strings& types) const
+    {
+        Vec<char> rslt(types_.size(), 0);
+        for (const auto& var : types)
+        {
+            auto it = std::find(types_.begin(), types_.end(), var);
+            if (it != types_.end())
+                rslt[static_cast<size_t>(it - types_.begin())] = 1;
+        }
+
+        return rslt;
     }
 
-    size_t count(bool isRecursive = true) const { return fileCount(isRecursive) + dirCount(isRecursive); }
+    Vec<Node_> nodes_;
+    Strings types_;
+    size_t probeSize_ = 0;
+};
 
-    bool empty() const { return size() == 0; }
+/// @brief The statistics of a stage of the Pipeline.
+struct StageStats
+{
+    String name;
+    size_t concurrency = 0;
+    /// @brief The count of the items processed (emitted by the source stage).
+    size_t items = 0;
+    /// @brief The time of the workers processing the items (summed by the workers).
+    std::chrono::nanoseconds busy{ 0 };
+    /// @brief The time of the workers waiting the input items, the stage is starved by the upstream.
+    std::chrono::nanoseconds starved{ 0 };
+    /// @brief The time of the workers waiting the output queue, the stage is blocked by the downstream (backpressure).
+    std::chrono::nanoseconds blocked{ 0 };
+    /// @brief The time from the pipeline started to the stage finished.
+    std::chrono::nanoseconds elapsed{ 0 };
+
+    double itemsPerSecond() const { return elapsed.count() > 0 ? items * 1e9 / elapsed.count() : 0.0; }
+};
 
-    bool hasFile(const String& name, bool isRecursive = false) const
+/// @brief The bounded blocking queue between the stages of the Pipeline.
+template <typename T>
+class _PipelineQueue
+{
+public:
+    explicit _PipelineQueue(size_t capacity) : capacity_(capacity == 0 ? 1 : capacity) {}
+
+    /// @return False if the queue is closed.
+    bool push(T&& item, std::atomic<int64_t>& waitNs)
     {
-        if (hasFile_(name) != NOF_)
-            return true;
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
 
-        if (isRecursive && subDirs_)
-        {
-            for (const auto& var : *subDirs_)
-            {
-                if (var.hasFile(name, true))
-                    return true;
-            }
-        }
+        notFull_.wait(lock, [this]() { return isClosed_ || items_.size() < capacity_; });
+        waitNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
 
-        return false;
+        if (isClosed_)
+            return false;
+
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
     }
 
-    bool hasDir(const String& name, bool isRecursive = false) const
+    /// @return False if the queue is closed and empty (or aborted).
+    bool pop(T& item, std::atomic<int64_t>& waitNs)
     {
-        if (hasDir_(name) != NOF_)
-            return true;
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
 
-        if (isRecursive && subDirs_)
-        {
-            for (const auto& var : *subDirs_)
-            {
-                if (var.hasDir(name, true))
-                    return true;
-            }
-        }
+        notEmpty_.wait(lock, [this]() { return isClosed_ || !items_.empty(); });
+        waitNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
 
-        return false;
-    }
+        if (items_.empty())
+            return false;
 
-    void setName(const String& name)
-    {
-        if (!isValidFilename(name))
-            throw Exception(_fmt("Invalid file name: \"{}\"", name));
-        name_ = name;
+        item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
     }
 
-    const Vec<File>& files() const { return *subFiles_; }
+    /// @brief No more items are pushed, the remaining items can still be popped.
+    /// @param isAbort If true, the remaining items are dropped.
+    void close(bool isAbort = false)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
 
-    const Vec<Dir>& dirs() const { return *subDirs_; }
+        isClosed_ = true;
+        if (isAbort)
+            items_.clear();
 
-    Vec<File>& files() { return *subFiles_; }
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
 
-    Vec<Dir>& dirs() { return *subDirs_; }
+private:
+    size_t capacity_;
+    std::deque<T> items_;
+    bool isClosed_ = false;
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+};
 
-    File& file(const String& name)
+/// @brief The stages and the queues of the Pipeline, shared by the builders.
+struct _PipelineGraph
+{
+    struct Stage
     {
-        size_t pos = hasFile_(name);
+        String name;
+        size_t concurrency;
+        std::function<void(Stage&)> work;
+        /// @brief Called by the last finished worker of the stage (close the output queue).
+        std::function<void(bool isAbort)> finish;
+
+        std::atomic<size_t> remaining{ 0 };
+        std::atomic<size_t> items{ 0 };
+        std::atomic<int64_t> busy{ 0 };
+        std::atomic<int64_t> starved{ 0 };
+        std::atomic<int64_t> blocked{ 0 };
+        std::atomic<int64_t> elapsed{ 0 };
+    };
+
+    Vec<std::unique_ptr<Stage>> stages;
+    std::mutex mutex;
+    std::exception_ptr error;
+    bool isRun = false;
+
+    Stage& add(String name, size_t concurrency)
+    {
+        stages.emplace_back(new Stage());
+        stages.back()->name = std::move(name);
+        stages.back()->concurrency = concurrency == 0 ? 1 : concurrency;
+        return *stages.back();
+    }
 
-        if (pos == NOF_)
+    /// @brief Stop all the stages, the items in the queues are dropped.
+    void abort(std::exception_ptr _error)
+    {
         {
-            add(File(name));
-            return subFiles_->back();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+                error = _error;
         }
 
-        return (*subFiles_)[pos];
+        for (auto& stage : stages)
+        {
+            if (stage->finish)
+                stage->finish(true);
+        }
     }
 
-    Dir& dir(const String& name)
+    /// @brief Run all the stages (each worker in a dedicated thread) until the sink stage finished.
+    /// @note The first exception thrown by the stages is rethrown after all the workers are stopped.
+    Vec<StageStats> run()
     {
-        size_t pos = hasDir_(name);
+        if (isRun)
+            throw Exception("The pipeline is already run.");
+        isRun = true;
 
-        if (pos == NOF_)
+        auto start = std::chrono::steady_clock::now();
+        Vec<std::thread> threads;
+
+        for (auto& _stage : stages)
         {
-            add(Dir(name));
-            return subDirs_->back();
+            Stage* stage = _stage.get();
+            stage->remaining = stage->concurrency;
+
+            for (size_t i = 0; i < stage->concurrency; ++i)
+            {
+                threads.emplace_back([this, stage, start]()
+                {
+                    try
+                    {
+                        stage->work(*stage);
+                    }
+                    catch (...)
+                    {
+                        abort(std::current_exception());
+                    }
+
+                    if (--stage->remaining == 0)
+                    {
+                        stage->elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+
+                        if (stage->finish)
+                            stage->finish(false);
+                    }
+                });
+            }
         }
 
-        return (*subDirs_)[pos];
-    }
+        for (auto& thread : threads)
+            thread.join();
 
-    void removeFile(const String& name)
-    {
-        size_t pos = hasFile_(name);
-        if (pos == NOF_)
-            return;
+        if (error)
+            std::rethrow_exception(error);
 
-        subFiles_->erase(subFiles_->begin() + pos);
+        Vec<StageStats> rslt;
+        for (auto& stage : stages)
+        {
+            StageStats stats;
+            stats.name = stage->name;
+            stats.concurrency = stage->concurrency;
+            stats.items = stage->items;
+            stats.busy = std::chrono::nanoseconds(stage->busy.load());
+            stats.starved = std::chrono::nanoseconds(stage->starved.load());
+            stats.blocked = std::chrono::nanoseconds(stage->blocked.load());
+            stats.elapsed = std::chrono::nanoseconds(stage->elapsed.load());
+            rslt.push_back(std::move(stats));
+        }
+
+        return rslt;
     }
+};
 
-    void removeDir(const String& name)
+/// @brief The builder of the multi-stage pipeline, the stages run concurrently and are connected by the bounded queues,
+/// so the memory is bounded (backpressure) and the total time approaches the slowest stage.
+/// Each stage has its own concurrency (the count of the worker threads), the order of the items is not kept
+/// if the concurrency of a stage is more than 1.
+/// @note A pipeline can be run once, and the builders of a pipeline share the stages (just use the last one).
+/// @note The items must be default constructible and movable.
+// @example
+// auto stats = Pipeline<String>::scan("dir")
+//     .filter("filter", [](const String& path) { return extension(path) == ".txt"; })
+//     .map("read", [](String path) { return File::fromDiskPath(path); }, 4)
+//     .forEach("write", [](File file) { file.write("out"); }, 2);
+template <typename T>
+class Pipeline
+{
+public:
+    /// @brief The function to push an item to the next stage, return false if the pipeline is aborted.
+    using Emit = std::function<bool(T)>;
+
+    /// @brief Start a pipeline by the source function, which calls the emit for each item.
+    /// @param capacity The capacity of the output queue.
+    static Pipeline source(String name, std::function<void(const Emit&)> func, size_t capacity = 64)
     {
-        size_t pos = hasDir_(name);
-        if (pos == NOF_)
-            return;
+        auto graph = std::make_shared<_PipelineGraph>();
+        auto output = std::make_shared<_PipelineQueue<T>>(capacity);
 
-        subDirs_->erase(subDirs_->begin() + pos);
-    }
+        _PipelineGraph::Stage& stage = graph->add(std::move(name), 1);
+        stage.finish = [output](bool isAbort) { output->close(isAbort); };
+        stage.work = [func, output](_PipelineGraph::Stage& stage)
+        {
+            auto start = std::chrono::steady_clock::now();
 
-    void releaseAllFilesData()
-    {
-        if (subFiles_)
-            for (auto& var : *subFiles_)
-                var.releaseData();
+            func([&](T item) -> bool
+            {
+                ++stage.items;
+                return output->push(std::move(item), stage.blocked);
+            });
 
-        if (subDirs_)
-            for (auto& var : *subDirs_)
-                var.releaseAllFilesData();
+            stage.busy = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count() - stage.blocked;
+        };
+
+        return Pipeline(graph, output);
     }
 
-    void clearFiles()
+    /// @brief Start a pipeline by the paths of the files in the directory, the files are streamed during the walking.
+    static Pipeline scan(const String& path, bool isRecursive = true, size_t capacity = 1024)
     {
-        if (subFiles_)
+        return source("scan", [path, isRecursive](const Emit& emit)
         {
-            delete subFiles_;
-            subFiles_ = nullptr;
-        }
+            walkFiles(path, isRecursive, [&](const String& file) { return emit(file); });
+        }, capacity);
     }
 
-    void clearDirs()
+    /// @brief Add a stage which transforms each item by the func.
+    template <typename Func>
+    auto map(String name, Func func, size_t concurrency = 1, size_t capacity = 64)
+        -> Pipeline<typename std::decay<decltype(func(std::declval<T>()))>::type>
     {
-        if (subDirs_)
+        using U = typename std::decay<decltype(func(std::declval<T>()))>::type;
+
+        auto input = input_;
+        auto output = std::make_shared<_PipelineQueue<U>>(capacity);
+
+        _PipelineGraph::Stage& stage = graph_->add(std::move(name), concurrency);
+        stage.finish = [output](bool isAbort) { output->close(isAbort); };
+        stage.work = [func, input, output](_PipelineGraph::Stage& stage)
         {
-            delete subDirs_;
-            subDirs_ = nullptr;
-        }
+            T item;
+            while (input->pop(item, stage.starved))
+            {
+                auto start = std::chrono::steady_clock::now();
+                U rslt = func(std::move(item));
+                stage.busy += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                ++stage.items;
+
+                if (!output->push(std::move(rslt), stage.blocked))
+                    break;
+            }
+        };
+
+        return Pipeline<U>(graph_, output);
     }
 
-    void clear()
+    /// @brief Add a stage which drops the items not satisfied the pred.
+    Pipeline filter(String name, std::function<bool(const T&)> pred, size_t concurrency = 1, size_t capacity = 64)
     {
-        clearFiles();
-        clearDirs();
+        auto input = input_;
+        auto output = std::make_shared<_PipelineQueue<T>>(capacity);
+
+        _PipelineGraph::Stage& stage = graph_->add(std::move(name), concurrency);
+        stage.finish = [output](bool isAbort) { output->close(isAbort); };
+        stage.work = [pred, input, output](_PipelineGraph::Stage& stage)
+        {
+            T item;
+            while (input->pop(item, stage.starved))
+            {
+                auto start = std::chrono::steady_clock::now();
+                bool isKeep = pred(item);
+                stage.busy += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                ++stage.items;
+
+                if (isKeep && !output->push(std::move(item), stage.blocked))
+                    break;
+            }
+        };
+
+        return Pipeline(graph_, output);
     }
 
-    void add(File& file, bool isOverwrite = false)
+    /// @brief Add the sink stage which consumes each item by the func, and run the pipeline until all items consumed.
+    /// @return The statistics of each stage.
+    Vec<StageStats> forEach(String name, std::function<void(T)> func, size_t concurrency = 1)
     {
-        if (!subFiles_)
-            subFiles_ = new Vec<File>();
-
-        size_t pos = hasFile_(file.name());
+        auto input = input_;
 
-        if (pos != NOF_)
+        _PipelineGraph::Stage& stage = graph_->add(std::move(name), concurrency);
+        stage.finish = [input](bool isAbort)
         {
-            if (isOverwrite)
-                (*subFiles_)[pos] = std::move(file);
-            return;
-        }
+            if (isAbort)
+                input->close(true);
+        };
+        stage.work = [func, input](_PipelineGraph::Stage& stage)
+        {
+            T item;
+            while (input->pop(item, stage.starved))
+            {
+                auto start = std::chrono::steady_clock::now();
+                func(std::move(item));
+                stage.busy += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                ++stage.items;
+            }
+        };
 
-        subFiles_->emplace_back(std::move(file));
+        return graph_->run();
     }
 
-    void add(Dir& dir, bool isOverwrite = false)
+    /// @brief Run the pipeline and collect all the items.
+    Vec<T> collect(Vec<StageStats>* stats = nullptr)
     {
-        if (!subDirs_)
-            subDirs_ = new Vec<Dir>();
-
-        size_t pos = hasDir_(dir.name());
+        Vec<T> rslt;
+        Vec<StageStats> _stats = forEach("collect", [&rslt](T item) { rslt.push_back(std::move(item)); });
 
-        if (pos != NOF_)
-        {
-            if (isOverwrite)
-                (*subDirs_)[pos] = std::move(dir);
-            return;
-        }
+        if (stats)
+            *stats = std::move(_stats);
 
-        subDirs_->emplace_back(std::move(dir));
+        return rslt;
     }
 
-    void add(File&& file, bool isOverwrite = false) { add(file, isOverwrite); }
+private:
+    template <typename U>
+    friend class Pipeline;
 
-    void add(Dir&& dir, bool isOverwrite = false) { add(dir, isOverwrite); }
+    Pipeline(std::shared_ptr<_PipelineGraph> graph, std::shared_ptr<_PipelineQueue<T>> input) :
+        graph_(std::move(graph)), input_(std::move(input))
+    {}
 
-    void write(const String& path, bool isOverwrite = false,
-               std::ios_base::openmode openmode = std::ios_base::binary) const
-    {
-        String root = String(path) + PREFERRED_PATH_SEPARATOR + name_;
+    std::shared_ptr<_PipelineGraph> graph_;
+    /// @brief The output queue of the last stage, as the input of the next stage.
+    std::shared_ptr<_PipelineQueue<T>> input_;
+};
 
-        createDirectory(root);
+#endif // !WFS_IMPL
 
-        if (subFiles_)
-            for (const auto& var : *subFiles_)
-                var.write(root, isOverwrite, openmode);
+} // namespace wfs
 
-        if (subDirs_)
-            for (const auto& var : *subDirs_)
-                var.write(root, isOverwrite);
-    }
+// Coroutine awaitables.
+// (The operations run in the executor, or complete by themselves without blocking any thread, e.g. the loading of the
+// files by the io_uring, and the awaiting coroutine is resumed in the executor thread.)
+#if defined(_WRAPPED_FILESYS_COROUTINE) && !defined(WFS_IMPL)
 
-    Dir copy() const { return Dir(*this); }
+namespace wfs
+{
 
-    Dir& operator[](const String& name) { return dir(name); }
+/// @brief The awaitable of a function which runs in the executor when the awaitable is awaited,
+/// the result (or the exception) of the function is returned (or rethrown) by the co_await.
+/// @note Just awaitable once.
+template <typename T>
+class Awaitable
+{
+public:
+    /// @brief Complete the operation with the result, or with the exception (then the result is ignored).
+    using Callback = std::function<void(std::conditional_t<std::is_void_v<T>, bool, T>, std::exception_ptr)>;
+
+    /// @param executor The executor to run the func, nullptr means the ioExecutor().
+    Awaitable(std::function<T()> func, Executor* executor) :
+        func_(std::move(func)), executor_(executor != nullptr ? executor : &ioExecutor())
+    {}
+
+    /// @brief The awaitable of an operation which completes by itself (e.g. by the io_uring), the start is called
+    /// with the callback in the awaiting thread when the awaitable is awaited, and the awaiting coroutine is resumed
+    /// in the executor (nullptr means the ioExecutor()) when the callback is called.
+    static Awaitable fromCallback(std::function<void(Callback)> start, Executor* executor)
+    {
+        Awaitable rslt(nullptr, executor);
+        rslt.start_ = std::move(start);
+        return rslt;
+    }
 
-    File& operator()(const String& name) { return file(name); }
+    bool await_ready() const noexcept { return false; }
 
-    Dir& operator<<(File& file)
+    void await_suspend(std::coroutine_handle<> handle)
     {
-        add(file);
-        return *this;
+        // The handle may be resumed (and this awaitable destroyed) before the start() or the submit() returns,
+        // so don't touch the members after them.
+        if (start_)
+        {
+            std::function<void(Callback)> start = std::move(start_);
+            Executor* executor = executor_;
+            start([this, handle, executor](Result_ rslt, std::exception_ptr error)
+            {
+                if (error)
+                    error_ = std::move(error);
+                else
+                    rslt_.emplace(std::move(rslt));
+
+                executor->submit([handle]() { handle.resume(); });
+            });
+            return;
+        }
+
+        executor_->submit([this, handle]()
+        {
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                {
+                    func_();
+                    rslt_.emplace(true);
+                }
+                else
+                {
+                    rslt_.emplace(func_());
+                }
+            }
+            catch (...)
+            {
+                error_ = std::current_exception();
+            }
+
+            handle.resume();
+        });
     }
 
-    Dir& operator<<(Dir& dir)
+    T await_resume()
     {
-        add(dir);
-        return *this;
+        if (error_)
+            std::rethrow_exception(error_);
+
+        if constexpr (!std::is_void_v<T>)
+            return std::move(*rslt_);
     }
 
-    Dir& operator<<(File&& file)
+private:
+    using Result_ = std::conditional_t<std::is_void_v<T>, bool, T>;
+
+    std::function<T()> func_;
+    std::function<void(Callback)> start_;
+    Executor* executor_;
+    std::optional<Result_> rslt_;
+    std::exception_ptr error_;
+};
+
+/// @brief Run the func in the executor (nullptr means the ioExecutor()) when the result is awaited.
+template <typename Func>
+auto asyncRun(Func func, Executor* executor = nullptr) -> Awaitable<decltype(func())>
+{
+    return Awaitable<decltype(func())>(std::move(func), executor);
+}
+
+/// @return The exception of the first file failed to read by the _readFilesAsync(), nullptr if none.
+inline std::exception_ptr _readFilesError(const Strings& filenames, const Vec<std::error_code>& errors)
+{
+    for (size_t i = 0; i < filenames.size(); ++i)
     {
-        add(file);
-        return *this;
+        if (errors[i])
+            return std::make_exception_ptr(
+                Exception(_fmt("Failed to open the file: \"{}\" ({})", filenames[i], errors[i].message())));
     }
 
-    Dir& operator<<(Dir&& dir)
+    return nullptr;
+}
+
+/// @brief The files of the contents read by the _readFilesAsync().
+inline Vec<File> _filesFromContents(const Strings& filenames, Strings& contents)
+{
+    Vec<File> rslt;
+    rslt.reserve(filenames.size());
+
+    for (size_t i = 0; i < filenames.size(); ++i)
     {
-        add(dir);
-        return *this;
+        rslt.emplace_back(filenameEx(filenames[i]));
+        rslt.back() = std::move(contents[i]);
     }
 
-private:
-    static constexpr size_t NOF_ = size_t(-1);
+    return rslt;
+}
 
-    size_t hasFile_(const String& name) const
+/// @brief Load the file, by the io_uring in Linux (if available) without blocking any thread while reading,
+/// otherwise by the executor, see the _readFilesAsync().
+inline Awaitable<File> asyncFromDiskPath(String filename, Executor* executor = nullptr)
+{
+    return Awaitable<File>::fromCallback([filename = std::move(filename), executor](Awaitable<File>::Callback callback)
     {
-        if (subFiles_)
+        _readFilesAsync({ filename }, executor, [filename, callback](Strings& contents, Vec<std::error_code>& errors)
         {
-            for (size_t i = 0; i < subFiles_->size(); ++i)
-            {
-                if ((*subFiles_)[i].name() == name)
-                    return i;
-            }
-        }
-
-        return NOF_;
-    }
+            std::exception_ptr error = _readFilesError({ filename }, errors);
+            if (error)
+                callback(File(), std::move(error));
+            else
+                callback(std::move(_filesFromContents({ filename }, contents).front()), nullptr);
+        });
+    }, executor);
+}
 
-    size_t hasDir_(const String& name) const
+/// @brief Load the files (the results are by the given order), same as the asyncFromDiskPath() but many files are
+/// in flight of the io_uring at once.
+inline Awaitable<Vec<File>> asyncFromDiskPaths(Strings filenames, Executor* executor = nullptr)
+{
+    using Callback = Awaitable<Vec<File>>::Callback;
+    return Awaitable<Vec<File>>::fromCallback([filenames = std::move(filenames), executor](Callback callback)
     {
-        if (subDirs_)
+        _readFilesAsync(filenames, executor, [filenames, callback](Strings& contents, Vec<std::error_code>& errors)
         {
-            for (size_t i = 0; i < subDirs_->size(); ++i)
-            {
-                if ((*subDirs_)[i].name() == name)
-                    return i;
-            }
-        }
+            std::exception_ptr error = _readFilesError(filenames, errors);
+            callback(error ? Vec<File>() : _filesFromContents(filenames, contents), std::move(error));
+        });
+    }, executor);
+}
 
-        return NOF_;
-    }
+inline Awaitable<Dir> asyncDirFromDiskPath(String dirpath, Executor* executor = nullptr)
+{
+    return asyncRun([dirpath = std::move(dirpath)]() { return Dir::fromDiskPath(dirpath); }, executor);
+}
 
-    String name_;
-    Vec<File>* subFiles_ = nullptr;
-    Vec<Dir>* subDirs_ = nullptr;
-};
+inline Awaitable<FileStatus> asyncStatus(String path, Executor* executor = nullptr)
+{
+    return asyncRun([path = std::move(path)]() { return status(path); }, executor);
+}
 
-#endif // !WFS_IMPL
+inline Awaitable<size_t> asyncSizes(String path, Executor* executor = nullptr)
+{
+    return asyncRun([path = std::move(path)]() { return sizes(path); }, executor);
+}
+
+inline Awaitable<void> asyncCopyFile(String src, String dst, bool isOverwrite = false, Executor* executor = nullptr)
+{
+    return asyncRun([src = std::move(src), dst = std::move(dst), isOverwrite]() { copyFile(src, dst, isOverwrite); },
+                    executor);
+}
+
+inline Awaitable<void> asyncCopys(String src, String dst, bool isOverwrite = false, Executor* executor = nullptr)
+{
+    return asyncRun([src = std::move(src), dst = std::move(dst), isOverwrite]() { copys(src, dst, isOverwrite); },
+                    executor);
+}
+
+inline Awaitable<size_t> asyncDeletes(String path, Executor* executor = nullptr)
+{
+    return asyncRun([path = std::move(path)]() { return deletes(path); }, executor);
+}
+
+inline Awaitable<bool> asyncCreateDirectorys(String path, Executor* executor = nullptr)
+{
+    return asyncRun([path = std::move(path)]() { return createDirectorys(path); }, executor);
+}
+
+inline Awaitable<Strings> asyncGetAllFiles(String path, bool isRecursive = true,
+                                           bool (*filter)(const String&) = nullptr, Executor* executor = nullptr)
+{
+    return asyncRun([path = std::move(path), isRecursive, filter]() { return getAllFiles(path, isRecursive, filter); },
+                    executor);
+}
+
+inline Awaitable<Strings> asyncGetAllDirectorys(String path, bool isRecursive = true,
+                                                bool (*filter)(const String&) = nullptr, Executor* executor = nullptr)
+{
+    return asyncRun([path = std::move(path), isRecursive, filter]()
+                    { return getAllDirectorys(path, isRecursive, filter); }, executor);
+}
+
+inline Awaitable<std::pair<Strings, Strings>> asyncGetAlls(String path, bool isRecursive = true,
+                                                           bool (*filter)(const String&) = nullptr,
+                                                           Executor* executor = nullptr)
+{
+    return asyncRun([path = std::move(path), isRecursive, filter]() { return getAlls(path, isRecursive, filter); },
+                    executor);
+}
 
 } // namespace wfs
 
+#endif // _WRAPPED_FILESYS_COROUTINE && !WFS_IMPL
+
 #endif // !WRAPPED_FILESYS_HPP